@@ -0,0 +1,269 @@
+#ifndef COOL_LEX_H_
+#define COOL_LEX_H_
+
+/*
+ *  Scanner interface beyond cool_yylex().
+ *
+ *  Every piece of scanner state lives in a lex_context, so any number of
+ *  scanners can run at once, each on its own thread.  cool_yylex() keeps
+ *  one context for fin and mirrors it into curr_lineno and cool_yylval.
+ */
+
+#include <stdio.h>
+#include <vector>
+#include <cool-parse.h>
+
+/* Max size of string constants */
+#define MAX_STR_CONST 1025
+
+/*
+ * Input modes.
+ * A regular file is mapped privately and flex scans the mapped pages in
+ * place, so the YY_INPUT copy is skipped entirely.  Pipes and terminals
+ * fall back to streaming through YY_INPUT.
+ * Setting COOL_LEX_INPUT=stream in the environment forces streaming.
+ */
+enum lex_input_mode_type { LEX_INPUT_STREAM, LEX_INPUT_MMAP };
+extern int lex_input_mode;
+
+/*
+ * Scanner backends.
+ * flex    the rules in cool.flex.
+ * fast    the hand-written scanner at the end of cool.flex.
+ * verify  runs both over the same input, checks every token of one
+ *         against the other, and stops at the first difference.
+ * parallel  lexes the whole file up front with lex_parallel() on
+ *         COOL_LEX_THREADS threads (default: one per CPU).
+ * COOL_LEX_BACKEND=flex|fast|verify|parallel picks one at startup.
+ * fast and parallel need a build with -DLEX_FAST_BACKENDS until the
+ * hand-written scanner has been checked against flex (lex-verify.sh).
+ */
+enum lex_backend_type { LEX_FLEX, LEX_FAST, LEX_VERIFY, LEX_PARALLEL };
+extern int lex_backend;
+extern int lex_threads;
+
+/*
+ * Interning.
+ * Tokens are normally interned through a hash index (string-index.h)
+ * kept in step with the string tables.  COOL_LEX_INTERN=list goes
+ * straight to StringTable::add_string() instead.
+ */
+enum lex_intern_mode_type { LEX_INTERN_HASH, LEX_INTERN_LIST };
+extern int lex_intern_mode;
+
+enum fast_state_type { FAST_INITIAL, FAST_COMMENT, FAST_STRING, FAST_STRING_ERROR };
+
+struct fast_lexer_type
+{
+	char *cur;
+	char *end;
+	int lineno;
+
+	int state;
+	int comment_level;
+
+	char string_buf[MAX_STR_CONST];
+	char *string_buf_ptr;
+	char *string_error_msg;
+
+	/*
+	 * With defer_intern set, symbol tokens come back with a NULL symbol
+	 * and the caller interns [token_start, cur) itself.
+	 */
+	bool defer_intern;
+	char *token_start;
+
+	fast_lexer_type() : cur( NULL), end( NULL), lineno( 1),
+		state( FAST_INITIAL), comment_level( 0),
+		string_buf_ptr( string_buf), string_error_msg( NULL),
+		defer_intern( false), token_start( NULL) {}
+
+	void reset( char *base, size_t size, int line);
+
+	int lex( YYSTYPE &val);
+
+	private:
+	int lex_initial( YYSTYPE &val);
+	int lex_comment( YYSTYPE &val);
+	int lex_string( YYSTYPE &val);
+	int lex_string_error( YYSTYPE &val);
+
+	int error( YYSTYPE &val, const char *msg)
+	{
+		val.error_msg = ( char *) msg;
+		return ERROR;
+	}
+
+	void start_comment()
+	{
+		if ( comment_level == 0)
+		{
+			state = FAST_COMMENT;
+		}
+		++comment_level;
+	}
+
+	void end_comment()
+	{
+		--comment_level;
+		if ( comment_level == 0)
+		{
+			state = FAST_INITIAL;
+		}
+	}
+
+	bool string_append( char c)
+	{
+		if ( string_buf_ptr - string_buf == MAX_STR_CONST - 1)
+		{
+			state = FAST_STRING_ERROR;
+			string_error_msg = ( char *) "String constant too long";
+			return false;
+		}
+		if ( c == '\0')
+		{
+			state = FAST_STRING_ERROR;
+			string_error_msg = ( char *) "String contains null character";
+			return false;
+		}
+		*string_buf_ptr++ = c;
+		return true;
+	}
+};
+
+struct lex_token_type
+{
+	int token;
+	int lineno;
+	YYSTYPE val;
+};
+
+struct yy_buffer_state;
+
+struct lex_context_type
+{
+	FILE *fin;
+	int backend;
+
+	/*
+	 * When the source is mapped (or, for the hand-written scanner,
+	 * slurped from a pipe) input_base holds all of it, followed by the
+	 * two NULs flex wants as end-of-buffer sentinels.
+	 */
+	char *input_base;
+	size_t input_size;
+	size_t input_len;	/* mapped length, 0 when malloced */
+
+	void *flex;	/* yyscan_t */
+	struct yy_buffer_state *flex_buffer;
+	fast_lexer_type fast;
+
+	/* Everything lex_parallel() found, handed out in order. */
+	std::vector< lex_token_type> tokens;
+	size_t next_token;
+
+	/*
+	 * What the flex rules used to keep in globals; they reach it
+	 * through yyextra.
+	 */
+	int lineno;
+	YYSTYPE val;
+	char string_buf[MAX_STR_CONST];
+	char *string_buf_ptr;
+	int comment_level;
+	char *string_error_msg;
+};
+typedef lex_context_type *lex_context;
+
+/*
+ * Drops cool_yylex()'s scanner, so that the next call starts afresh on
+ * fin.  It does so by itself at the end of input and when fin changes;
+ * a caller that leaves a file part way through calls this before
+ * reading another.
+ */
+void lex_restart();
+
+/*
+ * A scanner over file, starting at line lineno.  The file is only read,
+ * never closed.
+ */
+lex_context lex_context_new( FILE *file, int lineno);
+void lex_context_delete( lex_context ctx);
+
+/*
+ * The next token, 0 at end of input.  Its value is left in ctx->val and
+ * the current line in ctx->lineno.
+ */
+int lex_context_next( lex_context ctx);
+
+
+/*
+ * Lexes names[0 .. count) on up to threads threads, one file at a time
+ * per thread, appending the tokens of names[i] to tokens[i].  Error
+ * messages in the result point at static storage, so they outlive the
+ * scanners.  Returns false if any file could not be opened.
+ */
+bool lex_files( int count, char **names, std::vector< lex_token_type> *tokens, int threads);
+
+/*
+ * Lexes the buffer [base, base + size), loaded the way a lex_context
+ * loads its input, starting at line lineno, and appends its tokens to
+ * tokens.  The buffer is cut at newlines into chunks that are lexed
+ * speculatively on up to threads threads; the result, line numbers and
+ * symbol numbering included, is the same as one serial pass.
+ */
+void lex_parallel( char *base, size_t size, int lineno,
+		std::vector< lex_token_type> &tokens, int threads);
+
+/*
+ * Prints how often each flex rule and start condition fired, in a build
+ * with -DLEX_RULE_COUNTS.
+ */
+void lex_rule_report( ostream &out);
+
+/*
+ * A token stream that can be brought up to date after an edit without
+ * lexing the whole buffer again.  Each token remembers where it ended
+ * and the scanner state after it; relexing starts from the last token
+ * the edit can't have touched and stops as soon as a new token ends
+ * where an old one did, in the same state, past the edit.
+ *
+ * Buffers need one writable byte after them, as a terminating NUL
+ * would give.
+ */
+struct lex_stream_token_type
+{
+	int token;
+	int lineno;
+	YYSTYPE val;
+	size_t end;	/* offset just past the token */
+	int state;	/* scanner state after the token */
+	int comment_level;
+};
+
+struct lex_stream_type
+{
+	std::vector< lex_stream_token_type> tokens;
+	int first_lineno;
+
+	/*
+	 * What the last edit() did: tokens [changed_begin, changed_end)
+	 * are new, and took the place of changed_old old ones.
+	 */
+	size_t changed_begin;
+	size_t changed_end;
+	size_t changed_old;
+
+	lex_stream_type() : first_lineno( 1),
+		changed_begin( 0), changed_end( 0), changed_old( 0) {}
+
+	void lex( char *base, size_t size, int lineno = 1);
+
+	/*
+	 * The old text [edit_begin, old_end) is now [edit_begin, new_end)
+	 * of the size bytes at base.
+	 */
+	void edit( char *base, size_t size, size_t edit_begin, size_t old_end, size_t new_end);
+};
+
+#endif
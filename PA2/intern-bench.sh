@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Times the lexer on an identifier-heavy input, interning through the
+# hash index and through StringTable::add_string().
+#
+#   ./intern-bench.sh [names] [lexer] [modes]
+#
+# names  distinct identifiers to generate (default 150000); about as
+#        many distinct integers and strings come along with them.
+# lexer  scanner binary to run (default ./lexer); COOL_LEX_BACKEND is
+#        passed through, so the hand-written scanner can be timed too.
+# modes  COOL_LEX_INTERN settings to time (default "hash list").  The
+#        list is quadratic: at the default size it takes many minutes.
+
+names=${1:-150000}
+lexer=${2:-./lexer}
+modes=${3:-hash list}
+input=${TMPDIR:-/tmp}/intern-bench.$$.cl
+
+trap 'rm -f "$input"' EXIT INT TERM
+
+# Every name is defined once and used once more, so half the lookups
+# hit and half insert.
+awk -v n="$names" 'BEGIN {
+	print "class Main {";
+	for ( i = 0; i < n; i++)
+	{
+		printf "  attr_%x_%d : Int <- %d;\n", i * 2654435761 % 4294967296, i, i;
+		printf "  m%d() : String { { attr_%x_%d; \"s%d\"; } };\n", i, i * 2654435761 % 4294967296, i, i;
+	}
+	print "};";
+}' > "$input" || exit 1
+
+echo "$names names, `wc -c < "$input"` bytes"
+for mode in $modes
+do
+	printf '%-5s ' $mode
+	start=`date +%s.%N`
+	COOL_LEX_INTERN=$mode "$lexer" "$input" > /dev/null || exit 1
+	stop=`date +%s.%N`
+	echo "$start $stop" | awk '{ printf "%.3fs\n", $2 - $1 }'
+done
@@ -0,0 +1,97 @@
+#!/bin/sh
+#
+# Checks that the hand-written scanner gives the same tokens as the flex
+# rules (COOL_LEX_BACKEND) for every file given, and for a set of
+# inputs written here that go after the corners of the rules: nested
+# and unterminated comments, escapes, NULs and overlong strings, end of
+# file inside each, stray bytes, and the keywords' case rules.
+#
+#   ./lex-verify.sh [-l lexer] [file.cl ...]
+#
+# lexer    lexer binary to run (default ./lexer)
+#
+# Each input is lexed with COOL_LEX_BACKEND=verify, which runs both
+# scanners side by side and stops at the first token they disagree on,
+# and then with flex and with fast alone, whose listings must match to
+# the end.  Each input that fails is named with the start of the diff;
+# the exit status is the number of such inputs (at most 255).
+#
+#   ./lex-verify.sh ../../examples/*.cl ../../tests/PA2/*.cl
+#
+# The lexer must be built with -DLEX_FAST_BACKENDS, so that fast can be
+# picked on its own.
+
+lexer=./lexer
+while getopts l: opt
+do
+	case $opt in
+	l) lexer=$OPTARG ;;
+	*) exit 2 ;;
+	esac
+done
+shift `expr $OPTIND - 1`
+
+dir=${TMPDIR:-/tmp}/lex-verify.$$
+trap 'rm -rf "$dir"' EXIT INT TERM
+mkdir "$dir" "$dir/corpus" || exit 2
+
+# The generated inputs.  printf writes the odd bytes from octal.
+case_file()
+{
+	printf "$2" > "$dir/corpus/$1.cl"
+}
+case_file keywords 'cLaSs Inherits iNHERITS tRUE fALSE True False eLsE fi FI if IN let LOOP pool THEN while CASE esac OF new ISVOID not NOT\n'
+case_file idents 'x X x_1 X_1 _x a__b SELF_TYPE self Object 007 0 00 123456789012345678901234567890\n'
+case_file operators 'a<-b<=c=>d<e=f-g+h*i/j~k@l.m,n;o:p{q}r(s)t <- <= => -- dash comment\n-1--2\n'
+case_file blanks 'a\tb\vc\fd\re\n\n\r\nf \t\v\f\r g\n'
+case_file nested '(* a (* b *) c *) x (* (* (* *) *) *) y (**) z (*) still *) w\n'
+case_file comment_eof '(* open (* nested *)\nnever closed\n'
+case_file comment_stray 'a *) b (* c *) *) d\n'
+case_file comment_stars '(* ( * ( (* *)* ) *) x (*** ***) y (* -- *) z\n'
+case_file line_comment_eof 'x -- no newline at the end'
+case_file strings '"" "a" "a\\bb\\tc\\nd\\fe\\\\f\\"g" "\\x\\y\\z\\0" "tab\there"\n'
+case_file string_newline '"line one\\\nline two" "broken\nafter" x\n'
+case_file string_null '"a\000b" after "c\\\000d" after\n'
+case_file string_eof '"never closed\\'
+case_file string_eof2 'x "runs to the end'
+case_file empty ''
+case_file stray 'a ! b # c $ d %% e ^ f & g _ h ` i [ j ] k | l ? m '"'"' n \\ o > p\n'
+case_file bytes 'a\001b\177c\200d\377e\000f\n'
+awk 'BEGIN {
+	printf "\"";
+	for ( i = 0; i < 1024; i++) printf "a";
+	printf "\" \"";
+	for ( i = 0; i < 1025; i++) printf "b";
+	printf "\" \"";
+	for ( i = 0; i < 1023; i++) printf "c";
+	printf "\\n\" \"";
+	for ( i = 0; i < 2000; i++) printf "d";
+	printf "\\\n\" x\n";
+}' > "$dir/corpus/string_long.cl"
+
+checked=0
+failed=0
+for file in "$dir"/corpus/*.cl "$@"
+do
+	COOL_LEX_BACKEND=verify "$lexer" "$file" > "$dir/verify" 2>&1
+	status=$?
+	COOL_LEX_BACKEND=flex "$lexer" "$file" > "$dir/flex" 2>&1
+	COOL_LEX_BACKEND=fast "$lexer" "$file" > "$dir/fast" 2>&1
+	checked=`expr $checked + 1`
+
+	if [ $status -ne 0 ] || grep -q "^Scanner backends disagree" "$dir/verify"
+	then
+		echo "$file: verify stopped"
+		grep -A4 "^Scanner backends disagree" "$dir/verify"
+		failed=`expr $failed + 1`
+	elif ! cmp -s "$dir/flex" "$dir/fast"
+	then
+		echo "$file: backends differ"
+		diff "$dir/flex" "$dir/fast" | head -10
+		failed=`expr $failed + 1`
+	fi
+done
+
+echo "$checked files, $failed differ"
+[ $failed -gt 255 ] && failed=255
+exit $failed
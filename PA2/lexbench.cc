@@ -0,0 +1,331 @@
+/*
+ *  Scanner throughput benchmark.
+ *
+ *  Generates synthetic corpora and reports tokens/s and MB/s for each
+ *  scanner configuration, then the scaling of lex_files() with threads.
+ *
+ *    lexbench [megabytes-per-corpus] [corpus ...]
+ *
+ *  Corpora: ids (identifier-heavy), comments, strings, nested (deeply
+ *  nested comments).  All of them by default, 8 MB each.
+ *
+ *  Build it next to the scanner, with the same flags as lexer:
+ *
+ *    g++ -g -O2 -I. -I../../include/PA2 -I../../src/PA2 \
+ *        lexbench.cc cool-lex.cc utilities.cc stringtab.cc -lpthread -o lexbench
+ *
+ *  Compile cool-lex.cc and lexbench.cc with -DLEX_RULE_COUNTS as well to
+ *  get the per-rule and per-start-condition hit counts of the flex runs.
+ *
+ *  The fast and parallel rows time the hand-written scanner, which has
+ *  not yet been checked against the flex rules (see lex-verify.sh).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <string>
+#include <vector>
+
+#include <cool-parse.h>
+#include <stringtab.h>
+#include <utilities.h>
+#include "cool-lex.h"
+
+/* What the lexer driver would otherwise define. */
+FILE *fin;
+int curr_lineno = 1;
+YYSTYPE cool_yylval;
+int verbose_flag = 0;
+char *curr_filename = ( char *) "<lexbench>";
+
+/*
+ * Corpora.
+ */
+static void gen_ids( std::string &out, size_t size)
+{
+	static const char *ops[] = { " <- ", " + ", " <= ", " = ", ".", "(", ")", ";", ", ", " => " };
+	unsigned n = 0;
+	out += "class Main inherits IO {\n";
+	while ( out.size() < size)
+	{
+		char line[128];
+		// Mostly distinct names, with enough repeats to hit the tables.
+		unsigned a = n++ * 2654435761u;
+		unsigned b = a % 4096;
+		snprintf( line, sizeof( line), "  let name_%x : Type%u <- obj_%u%s%u in if x then y else z fi%s\n",
+				a, b % 64, b, ops[n % 10], n, ops[( n / 10) % 10]);
+		out += line;
+	}
+	out += "};\n";
+}
+
+static void gen_comments( std::string &out, size_t size)
+{
+	unsigned n = 0;
+	while ( out.size() < size)
+	{
+		char line[160];
+		if ( n % 3 == 0)
+		{
+			snprintf( line, sizeof( line),
+					"-- line comment %u with (parens) and *stars* and \"quotes\"\n", n);
+		}
+		else
+		{
+			snprintf( line, sizeof( line),
+					"(* block comment %u\n   over two lines, with ( and * inside *) x%u;\n", n, n);
+		}
+		out += line;
+		++n;
+	}
+}
+
+static void gen_strings( std::string &out, size_t size)
+{
+	unsigned n = 0;
+	while ( out.size() < size)
+	{
+		char line[600];
+		switch ( n % 4)
+		{
+			case 0:
+				snprintf( line, sizeof( line), "s <- \"plain string number %u\";\n", n);
+				break;
+			case 1:
+				snprintf( line, sizeof( line), "s <- \"with\\tescapes\\n and \\\"quotes\\\" %u\";\n", n);
+				break;
+			case 2:
+				snprintf( line, sizeof( line), "s <- \"line one\\\nline two %u\";\n", n);
+				break;
+			default:
+				snprintf( line, sizeof( line), "s <- \"%u %s\";\n", n,
+						"a long literal of the kind generated code is full of, "
+						"a long literal of the kind generated code is full of, "
+						"a long literal of the kind generated code is full of, "
+						"a long literal of the kind generated code is full of");
+				break;
+		}
+		out += line;
+		++n;
+	}
+}
+
+static void gen_nested( std::string &out, size_t size)
+{
+	unsigned n = 0;
+	while ( out.size() < size)
+	{
+		int depth = 1 + n % 64;
+		for ( int i = 0; i < depth; ++i)
+		{
+			out += "(* open ";
+		}
+		out += "\n middle ** (x) *\n";
+		for ( int i = 0; i < depth; ++i)
+		{
+			out += " close *)";
+		}
+		out += " token;\n";
+		++n;
+	}
+}
+
+static struct
+{
+	const char *name;
+	void ( *gen)( std::string &, size_t);
+} corpora[] = {
+	{ "ids", gen_ids },
+	{ "comments", gen_comments },
+	{ "strings", gen_strings },
+	{ "nested", gen_nested },
+	{ NULL, NULL }
+};
+
+/*
+ * Scanner configurations.
+ */
+static struct
+{
+	const char *name;
+	int backend;
+	int input_mode;
+} configs[] = {
+	{ "flex/stream", LEX_FLEX, LEX_INPUT_STREAM },
+	{ "flex/mmap", LEX_FLEX, LEX_INPUT_MMAP },
+	{ "fast", LEX_FAST, LEX_INPUT_MMAP },
+	{ "parallel", LEX_PARALLEL, LEX_INPUT_MMAP },
+	{ NULL, 0, 0 }
+};
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static long lex_file( const char *name)
+{
+	FILE *file = fopen( name, "r");
+	if ( !file)
+	{
+		perror( name);
+		exit( 1);
+	}
+
+	long tokens = 0;
+	lex_context ctx = lex_context_new( file, 1);
+	while ( lex_context_next( ctx))
+	{
+		++tokens;
+	}
+	lex_context_delete( ctx);
+	fclose( file);
+	return tokens;
+}
+
+static void report( const char *what, long tokens, size_t bytes, double secs)
+{
+	printf( "  %-14s %10ld tokens %8.3fs %12.0f tokens/s %8.1f MB/s\n",
+			what, tokens, secs, tokens / secs, bytes / secs / ( 1 << 20));
+}
+
+static void bench_corpus( const char *name, const std::string &text, const char *path)
+{
+	FILE *out = fopen( path, "w");
+	if ( !out || fwrite( text.data(), 1, text.size(), out) != text.size() || fclose( out))
+	{
+		perror( path);
+		exit( 1);
+	}
+
+	printf( "%s: %.1f MB\n", name, text.size() / ( double) ( 1 << 20));
+
+	// Warm the page cache and the string tables, so every configuration
+	// measures lookups rather than whichever came first paying for the
+	// inserts.
+	lex_backend = LEX_FAST;
+	lex_file( path);
+
+	for ( int c = 0; configs[c].name; ++c)
+	{
+		lex_backend = configs[c].backend;
+		lex_input_mode = configs[c].input_mode;
+
+		double start = now();
+		long tokens = lex_file( path);
+		report( configs[c].name, tokens, text.size(), now() - start);
+	}
+}
+
+/*
+ * lex_files() over copies of one corpus, with more and more threads.
+ */
+static void bench_files( const std::string &text, const char *dir)
+{
+	int cpus = sysconf( _SC_NPROCESSORS_ONLN);
+	int count = cpus < 4 ? 8 : cpus * 2;
+
+	std::vector< std::string> names( count);
+	std::vector< char *> argv( count);
+	for ( int i = 0; i < count; ++i)
+	{
+		char name[64];
+		snprintf( name, sizeof( name), "/file%d.cl", i);
+		names[i] = dir + std::string( name);
+		FILE *out = fopen( names[i].c_str(), "w");
+		if ( !out || fwrite( text.data(), 1, text.size(), out) != text.size() || fclose( out))
+		{
+			perror( names[i].c_str());
+			exit( 1);
+		}
+		argv[i] = ( char *) names[i].c_str();
+	}
+
+	printf( "lex_files: %d files of %.1f MB\n", count, text.size() / ( double) ( 1 << 20));
+	lex_backend = LEX_FAST;
+	lex_input_mode = LEX_INPUT_MMAP;
+	for ( int threads = 1; ; threads *= 2)
+	{
+		if ( threads > cpus)
+		{
+			threads = cpus;
+		}
+
+		std::vector< std::vector< lex_token_type> > tokens( count);
+		double start = now();
+		lex_files( count, &argv[0], &tokens[0], threads);
+		double secs = now() - start;
+
+		long total = 0;
+		for ( int i = 0; i < count; ++i)
+		{
+			total += tokens[i].size();
+		}
+		char what[32];
+		snprintf( what, sizeof( what), "%d threads", threads);
+		report( what, total, text.size() * count, secs);
+
+		if ( threads == cpus)
+		{
+			break;
+		}
+	}
+
+	for ( int i = 0; i < count; ++i)
+	{
+		unlink( argv[i]);
+	}
+}
+
+int main( int argc, char **argv)
+{
+	size_t size = ( argc > 1 ? atoi( argv[1]) : 8) << 20;
+
+	char dir[] = "/tmp/lexbench.XXXXXX";
+	if ( !mkdtemp( dir))
+	{
+		perror( "mkdtemp");
+		return 1;
+	}
+	std::string path = dir + std::string( "/corpus.cl");
+
+	std::string ids;
+	for ( int k = 0; corpora[k].name; ++k)
+	{
+		bool wanted = argc <= 2;
+		for ( int i = 2; i < argc; ++i)
+		{
+			wanted = wanted || !strcmp( argv[i], corpora[k].name);
+		}
+		if ( !wanted)
+		{
+			continue;
+		}
+
+		std::string text;
+		corpora[k].gen( text, size);
+		bench_corpus( corpora[k].name, text, path.c_str());
+		if ( corpora[k].gen == gen_ids)
+		{
+			ids = text;
+		}
+	}
+
+	if ( !ids.empty())
+	{
+		bench_files( ids, dir);
+	}
+
+#ifdef LEX_RULE_COUNTS
+	lex_rule_report( cout);
+#endif
+
+	unlink( path.c_str());
+	rmdir( dir);
+	return 0;
+}
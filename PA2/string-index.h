@@ -0,0 +1,215 @@
+#ifndef STRING_INDEX_H_
+#define STRING_INDEX_H_
+
+/*
+ *  A hash index in front of a StringTable.
+ *
+ *  StringTable::add_string() runs strlen() and then walks the whole
+ *  list comparing strings, so interning n distinct names costs O(n^2).
+ *  string_index_type finds the entry for (text, len) by open addressing
+ *  instead; slots carry the hash and length, so a probe only touches the
+ *  entry itself when those already match.
+ *
+ *  Entries it creates are pushed onto the table's own list with the
+ *  table's own numbering, just as add_string() would do it, so every
+ *  other user of the table (lookup, iteration, code_string_table) sees
+ *  no difference.  Entries added behind its back through add_string()
+ *  are picked up on the next call.
+ */
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <stringtab.h>
+
+/*
+ * Bump allocator for things that live as long as the program.
+ */
+struct string_arena_type
+{
+	enum { CHUNK = 1 << 16 };
+
+	char *cur;
+	char *end;
+
+	string_arena_type() : cur( NULL), end( NULL) {}
+
+	void *alloc( size_t size)
+	{
+		size = ( size + sizeof( void *) - 1) & ~( sizeof( void *) - 1);
+		if ( ( size_t) ( end - cur) < size)
+		{
+			size_t chunk = size > CHUNK ? size : CHUNK;
+			cur = ( char *) malloc( chunk);
+			if ( !cur)
+			{
+				abort();
+			}
+			end = cur + chunk;
+		}
+		void *p = cur;
+		cur += size;
+		return p;
+	}
+};
+
+/*
+ * Reaches the list StringTable keeps to itself.
+ */
+template <class Elem>
+struct string_table_access_type : StringTable<Elem>
+{
+	static List<Elem> *&list_of( StringTable<Elem> &table)
+	{
+		return table.*( &string_table_access_type::tbl);
+	}
+
+	static int &count_of( StringTable<Elem> &table)
+	{
+		return table.*( &string_table_access_type::index);
+	}
+};
+
+template <class Elem>
+class string_index_type
+{
+	struct slot_type
+	{
+		unsigned hash;
+		int len;
+		Elem *elem;	/* NULL when empty */
+	};
+
+	typedef string_table_access_type<Elem> access;
+
+	StringTable<Elem> &table;
+	slot_type *slots;
+	unsigned mask;
+	int used;
+	int synced;	/* table entries already in the index */
+	string_arena_type arena;
+
+	static unsigned hash_of( const char *text, int len)
+	{
+		// FNV-1a
+		unsigned h = 2166136261u;
+		for ( int i = 0; i < len; ++i)
+		{
+			h = ( h ^ ( unsigned char) text[i]) * 16777619u;
+		}
+		return h;
+	}
+
+	slot_type *probe( const char *text, int len, unsigned hash)
+	{
+		for ( unsigned i = hash & mask; ; i = ( i + 1) & mask)
+		{
+			slot_type *slot = &slots[i];
+			if ( !slot->elem)
+			{
+				return slot;
+			}
+			if ( slot->hash == hash && slot->len == len &&
+					!memcmp( slot->elem->get_string(), text, len))
+			{
+				return slot;
+			}
+		}
+	}
+
+	void grow()
+	{
+		slot_type *old = slots;
+		unsigned old_size = mask + 1;
+
+		mask = old_size * 2 - 1;
+		slots = ( slot_type *) calloc( mask + 1, sizeof( slot_type));
+		if ( !slots)
+		{
+			abort();
+		}
+		for ( unsigned i = 0; i < old_size; ++i)
+		{
+			if ( old[i].elem)
+			{
+				unsigned j = old[i].hash & mask;
+				while ( slots[j].elem)
+				{
+					j = ( j + 1) & mask;
+				}
+				slots[j] = old[i];
+			}
+		}
+		free( old);
+	}
+
+	void insert( slot_type *slot, Elem *elem, int len, unsigned hash)
+	{
+		slot->hash = hash;
+		slot->len = len;
+		slot->elem = elem;
+		if ( ++used * 2 > ( int) mask)
+		{
+			grow();
+		}
+	}
+
+	/*
+	 * New entries sit at the head of the table's list.
+	 */
+	void sync()
+	{
+		int count = access::count_of( table);
+		List<Elem> *l = access::list_of( table);
+		for ( ; synced < count && l; ++synced, l = l->tl())
+		{
+			Elem *elem = l->hd();
+			char *text = elem->get_string();
+			int len = elem->get_len();
+			unsigned hash = hash_of( text, len);
+			slot_type *slot = probe( text, len, hash);
+			if ( !slot->elem)
+			{
+				insert( slot, elem, len, hash);
+			}
+		}
+		synced = count;
+	}
+
+	public:
+	string_index_type( StringTable<Elem> &table) : table( table),
+		mask( 1023), used( 0), synced( 0)
+	{
+		slots = ( slot_type *) calloc( mask + 1, sizeof( slot_type));
+		if ( !slots)
+		{
+			abort();
+		}
+	}
+
+	Elem *add_string( char *text, int len)
+	{
+		if ( synced != access::count_of( table))
+		{
+			sync();
+		}
+
+		unsigned hash = hash_of( text, len);
+		slot_type *slot = probe( text, len, hash);
+		if ( slot->elem)
+		{
+			return slot->elem;
+		}
+
+		int &index = access::count_of( table);
+		Elem *elem = new ( arena.alloc( sizeof( Elem))) Elem( text, len, index);
+		access::list_of( table) = new ( arena.alloc( sizeof( List<Elem>)))
+			List<Elem>( elem, access::list_of( table));
+		synced = ++index;
+
+		insert( slot, elem, len, hash);
+		return elem;
+	}
+};
+
+#endif
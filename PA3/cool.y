@@ -150,6 +150,158 @@
 %type <expressions> expr_list
 %type <expressions> expr_list_semi
 
+%{
+#include <stdlib.h>
+#include <sys/time.h>
+
+/*
+ * Both parsers read their tokens through parse_yylex(), which counts
+ * them for COOL_PARSE_STATS.  The symbols the actions use are interned
+ * once, by parse_symbols(), rather than by each action.
+ */
+#undef yylex
+#define yylex parse_yylex
+
+int parse_yylex();
+static Symbol parse_filename();
+static Symbol Object_sym;
+static Symbol self_sym;
+static Symbol SELF_TYPE_sym;
+
+/*
+ * When parse_class_hook is set, each class is passed to it as soon as
+ * it joins the class list, while the rest of the input is still being
+ * parsed.  coolc builds semant's class table this way.
+ */
+void ( *parse_class_hook)( Class_) = NULL;
+static void parse_class_done( Class_ c);
+
+/*
+ * Hash-consing.
+ * With COOL_PARSE_SHARE=1, an expression equal to one built before,
+ * by constructor and by the identity of its symbols and children, is
+ * not built again: the earlier node takes its place, so that repeated
+ * subtrees are one subtree and semant checks it once.  The actions
+ * build expressions through the share_*() functions below, which do
+ * what the constructors do when sharing is off.  Which expressions may
+ * be shared is up to share_find().
+ *
+ * An error in a shared subtree is reported once, at the line of its
+ * first occurrence; the others are not reported at all.  The table
+ * lasts as long as the process, so a repeat in a later file reports
+ * nothing.  PA5/share-verify.sh checks that sharing changes no code.
+ */
+enum share_kind_type
+{
+	SHARE_STATIC_DISPATCH, SHARE_DISPATCH, SHARE_COND, SHARE_LOOP,
+	SHARE_BLOCK, SHARE_LET, SHARE_PLUS, SHARE_SUB, SHARE_MUL,
+	SHARE_DIVIDE, SHARE_NEG, SHARE_LT, SHARE_EQ, SHARE_LEQ, SHARE_COMP,
+	SHARE_INT_CONST, SHARE_BOOL_CONST, SHARE_STRING_CONST, SHARE_NEW,
+	SHARE_ISVOID, SHARE_NO_EXPR
+};
+
+struct share_key_type
+{
+	int kind;
+	int value;		/* a bool_const's, or a dispatch's line */
+	Symbol symbols[2];
+	Expression children[3];
+	Expressions list;	/* compared element by element */
+};
+
+static Expression share_hit;
+static bool share_find( const share_key_type &key);
+static Expression share_add( Expression e);
+
+/* The node for key: share_hit if there is one, else node, built only then. */
+#define SHARE( key, node) ( share_find( key) ? share_hit : share_add( node))
+
+#define SHARE_UNARY( ctor, kind) \
+	static Expression share_##ctor( Expression e) \
+	{ \
+		share_key_type key = { kind, 0, { NULL, NULL }, { e, NULL, NULL }, NULL }; \
+		return SHARE( key, ctor( e)); \
+	}
+
+#define SHARE_BINARY( ctor, kind) \
+	static Expression share_##ctor( Expression a, Expression b) \
+	{ \
+		share_key_type key = { kind, 0, { NULL, NULL }, { a, b, NULL }, NULL }; \
+		return SHARE( key, ctor( a, b)); \
+	}
+
+#define SHARE_SYMBOL( ctor, kind) \
+	static Expression share_##ctor( Symbol s) \
+	{ \
+		share_key_type key = { kind, 0, { s, NULL }, { NULL, NULL, NULL }, NULL }; \
+		return SHARE( key, ctor( s)); \
+	}
+
+SHARE_UNARY( neg, SHARE_NEG)
+SHARE_UNARY( comp, SHARE_COMP)
+SHARE_UNARY( isvoid, SHARE_ISVOID)
+SHARE_BINARY( plus, SHARE_PLUS)
+SHARE_BINARY( sub, SHARE_SUB)
+SHARE_BINARY( mul, SHARE_MUL)
+SHARE_BINARY( divide, SHARE_DIVIDE)
+SHARE_BINARY( lt, SHARE_LT)
+SHARE_BINARY( eq, SHARE_EQ)
+SHARE_BINARY( leq, SHARE_LEQ)
+SHARE_BINARY( loop, SHARE_LOOP)
+SHARE_SYMBOL( int_const, SHARE_INT_CONST)
+SHARE_SYMBOL( string_const, SHARE_STRING_CONST)
+SHARE_SYMBOL( new_, SHARE_NEW)
+
+static Expression share_bool_const( Boolean b)
+{
+	share_key_type key = { SHARE_BOOL_CONST, b, { NULL, NULL }, { NULL, NULL, NULL }, NULL };
+	return SHARE( key, bool_const( b));
+}
+
+static Expression share_no_expr()
+{
+	share_key_type key = { SHARE_NO_EXPR, 0, { NULL, NULL }, { NULL, NULL, NULL }, NULL };
+	return SHARE( key, no_expr());
+}
+
+static Expression share_cond( Expression pred, Expression then_exp, Expression else_exp)
+{
+	share_key_type key = { SHARE_COND, 0, { NULL, NULL }, { pred, then_exp, else_exp }, NULL };
+	return SHARE( key, cond( pred, then_exp, else_exp));
+}
+
+static Expression share_block( Expressions body)
+{
+	share_key_type key = { SHARE_BLOCK, 0, { NULL, NULL }, { NULL, NULL, NULL }, body };
+	return SHARE( key, block( body));
+}
+
+static Expression share_let( Symbol name, Symbol type, Expression init, Expression body)
+{
+	share_key_type key = { SHARE_LET, 0, { name, type }, { init, body, NULL }, NULL };
+	return SHARE( key, let( name, type, init, body));
+}
+
+static Expression share_dispatch( Expression e, Symbol name, Expressions actuals)
+{
+	share_key_type key = { SHARE_DISPATCH, node_lineno, { name, NULL }, { e, NULL, NULL },
+		actuals };
+	return SHARE( key, dispatch( e, name, actuals));
+}
+
+static Expression share_static_dispatch( Expression e, Symbol type, Symbol name,
+		Expressions actuals)
+{
+	share_key_type key = { SHARE_STATIC_DISPATCH, node_lineno, { type, name },
+		{ e, NULL, NULL }, actuals };
+	return SHARE( key, static_dispatch( e, type, name, actuals));
+}
+
+/* cool_yyparse() wraps the generated parser. */
+#undef yyparse
+#define yyparse parse_yyparse
+%}
+
     /* Precedence declarations go here. */
 
 %left IN
@@ -173,12 +325,15 @@
     class_list
     : class			/* single class */
     { $$ = single_Classes($1);
+    parse_class_done($1);
     parse_results = $$; }
     | error ';' class
     { $$ = single_Classes($3);
+    parse_class_done($3);
     parse_results = $$; }
     | class_list class	/* several classes */
     { $$ = append_Classes($1,single_Classes($2)); 
+    parse_class_done($2);
     parse_results = $$; }
     | class_list error ';'
     { $$ = $1;
@@ -187,10 +342,9 @@
     
     /* If no parent is specified, the class inherits from the Object class. */
     class	: CLASS TYPEID '{' dummy_feature_list '}' ';'
-    { $$ = class_($2,idtable.add_string("Object"),$4,
-    stringtable.add_string(curr_filename)); }
+    { $$ = class_($2,Object_sym,$4,parse_filename()); }
     | CLASS TYPEID INHERITS TYPEID '{' dummy_feature_list '}' ';'
-    { $$ = class_($2,$4,$6,stringtable.add_string(curr_filename)); }
+    { $$ = class_($2,$4,$6,parse_filename()); }
     ;
     
     /* Feature list may be empty, but no empty features in list. */
@@ -254,22 +408,22 @@ expr: OBJECTID ASSIGN expr
       $$ = assign( $1, $3); }
     | expr '.' OBJECTID '(' dummy_expr_list ')'
     { 
-      $$ = dispatch( $1, $3, $5); }
+      $$ = share_dispatch( $1, $3, $5); }
     | expr '@' TYPEID '.' OBJECTID '(' dummy_expr_list ')'
     { 
-      $$ = static_dispatch( $1, $3, $5, $7); }
+      $$ = share_static_dispatch( $1, $3, $5, $7); }
     | OBJECTID '(' dummy_expr_list ')'
     { 
-      $$ = dispatch( object( idtable.add_string("self")), $1, $3); }
+      $$ = share_dispatch( object( self_sym), $1, $3); }
     | IF expr THEN expr ELSE expr FI
     { 
-      $$ = cond( $2, $4, $6); }
+      $$ = share_cond( $2, $4, $6); }
     | WHILE expr LOOP expr POOL
     { 
-      $$ = loop( $2, $4); }
+      $$ = share_loop( $2, $4); }
     | '{' expr_list_semi '}'
     { 
-      $$ = block( $2); }
+      $$ = share_block( $2); }
     | LET let_expression
     { 
       $$ = $2; }
@@ -278,37 +432,37 @@ expr: OBJECTID ASSIGN expr
       $$ = typcase( $2, $4); }
     | NEW TYPEID
     { 
-      $$ = new_( $2); }
+      $$ = share_new_( $2); }
     | ISVOID expr
     { 
-      $$ = isvoid( $2); }
+      $$ = share_isvoid( $2); }
     | expr '+' expr
     { 
-      $$ = plus( $1, $3); }
+      $$ = share_plus( $1, $3); }
     | expr '-' expr
     { 
-      $$ = sub( $1, $3); }
+      $$ = share_sub( $1, $3); }
     | expr '*' expr
     { 
-      $$ = mul( $1, $3); }
+      $$ = share_mul( $1, $3); }
     | expr '/' expr
     { 
-      $$ = divide( $1, $3); }
+      $$ = share_divide( $1, $3); }
     | '~' expr
     { 
-      $$ = neg( $2); }
+      $$ = share_neg( $2); }
     | expr '<' expr
     { 
-      $$ = lt( $1, $3); }
+      $$ = share_lt( $1, $3); }
     | expr LE expr
     { 
-      $$ = leq( $1, $3); }
+      $$ = share_leq( $1, $3); }
     | expr '=' expr
     { 
-      $$ = eq( $1, $3); }
+      $$ = share_eq( $1, $3); }
     | NOT expr
     { 
-      $$ = comp( $2); }
+      $$ = share_comp( $2); }
     | '(' expr ')'
     { 
       $$ = $2; }
@@ -317,13 +471,13 @@ expr: OBJECTID ASSIGN expr
       $$ = object( $1); }
     | INT_CONST
     { 
-      $$ = int_const( $1); }
+      $$ = share_int_const( $1); }
     | STR_CONST
     { 
-      $$ = string_const( $1); }
+      $$ = share_string_const( $1); }
     | BOOL_CONST
     { 
-      $$ = bool_const( $1); }
+      $$ = share_bool_const( $1); }
     ;
 
 case_st: OBJECTID ':' TYPEID DARROW expr ';'
@@ -340,16 +494,16 @@ case_list : case_st
 
 let_expression: OBJECTID ':' TYPEID ',' let_expression
 	      { 
-	        $$ = let( $1, $3, no_expr(), $5); }
+	        $$ = share_let( $1, $3, share_no_expr(), $5); }
 	      | OBJECTID ':' TYPEID ASSIGN expr ',' let_expression
 	      { 
-	        $$ = let( $1, $3, $5, $7); }
+	        $$ = share_let( $1, $3, $5, $7); }
 	      | OBJECTID ':' TYPEID IN expr
 	      { 
-	        $$ = let( $1, $3, no_expr(), $5); }
+	        $$ = share_let( $1, $3, share_no_expr(), $5); }
 	      | OBJECTID ':' TYPEID ASSIGN expr IN expr
 	      { 
-	        $$ = let( $1, $3, $5, $7); }
+	        $$ = share_let( $1, $3, $5, $7); }
 	      | error ',' let_expression
 	      { 
 	        $$ = $3; }
@@ -391,18 +545,1053 @@ expr_list_semi: expr ';'
     /* end of grammar */
 %%
     
-    /* This function is called automatically when Bison detects a parse error. */
-    void yyerror(char *s)
+    /* Reports a parse error at token, the last one read. */
+    void parse_error(const char *s, int token)
     {
-      extern int curr_lineno;
-      
       cerr << "\"" << curr_filename << "\", line " << curr_lineno << ": " \
       << s << " at or near ";
-      print_cool_token(yychar);
+      print_cool_token(token);
       cerr << endl;
       omerrs++;
       
       if(omerrs>50) {fprintf(stdout, "More than 50 errors\n"); exit(1);}
     }
+
+    /* This function is called automatically when Bison detects a parse error. */
+    void yyerror(char *s)
+    {
+      parse_error(s, yychar);
+    }
     
 
+static long parse_tokens;	/* handed to the parser */
+
+/*
+ * curr_filename only changes between files, so the pointer last seen
+ * is compared first and the string only when the pointer differs.
+ */
+static Symbol parse_filename()
+{
+	static Symbol last = NULL;
+	static const char *last_name = NULL;
+	if ( curr_filename == last_name)
+	{
+		return last;
+	}
+	if ( curr_filename && ( !last || strcmp( last->get_string(), curr_filename)))
+	{
+		last = stringtable.add_string( curr_filename);
+	}
+	last_name = curr_filename;
+	return last;
+}
+
+static void parse_symbols()
+{
+	Object_sym = idtable.add_string( ( char *) "Object");
+	self_sym = idtable.add_string( ( char *) "self");
+	SELF_TYPE_sym = idtable.add_string( ( char *) "SELF_TYPE");
+}
+
+int parse_yylex()
+{
+	++parse_tokens;
+	return cool_yylex();
+}
+
+/* Hands each class to parse_class_hook as soon as it is parsed. */
+static void parse_class_done( Class_ c)
+{
+	if ( parse_class_hook)
+	{
+		parse_class_hook( c);
+	}
+}
+
+/*
+ * Hash-consing, continued.
+ * Only an expression that means the same wherever it appears is shared,
+ * so that the type semant gives it, and the code cgen makes for it at
+ * each of its occurrences, are right for all of them.  That leaves out
+ *   - object and assign, whose variable is looked up in scope,
+ *   - case, whose branches bind variables,
+ *   - anything that names SELF_TYPE, which is whatever class it is in,
+ *   - anything with a child that isn't shared itself,
+ * and by the last rule, a shared expression's type is never SELF_TYPE
+ * either.  A shared node keeps the line of its first occurrence, which
+ * is where an error in it is reported, once.  cgen puts a dispatch's
+ * line into its code, in the abort for a void receiver, so a dispatch's
+ * line is part of its key: it is only shared with copies on its line.
+ * No other expression cgen can share has its line in the code.
+ *
+ * The table lives as long as the process, so the files of one coolc
+ * run share with each other.
+ */
+struct share_slot_type
+{
+	unsigned hash;
+	share_key_type key;
+	Expression node;	/* NULL when empty */
+};
+
+static int share_on = -1;	/* not decided yet */
+static share_slot_type *share_slots;
+static Expression *share_nodes;	/* the same nodes, by address */
+static unsigned share_mask;
+static unsigned share_used;
+static share_slot_type *share_pending;	/* for share_add(), after a miss */
+
+/* Counted for COOL_PARSE_STATS. */
+static long share_lookups;
+static long share_hits;
+
+/* FNV-1a, a word at a time; addresses go in less their alignment. */
+static unsigned share_mix( unsigned h, unsigned word)
+{
+	return ( h ^ word) * 16777619u;
+}
+
+static unsigned share_address( const void *p)
+{
+	return ( unsigned) ( ( size_t) p >> 4);
+}
+
+static unsigned share_node_hash( Expression e)
+{
+	return share_mix( 2166136261u, share_address( e));
+}
+
+/* Whether e is absent or shared. */
+static bool share_closed( Expression e)
+{
+	if ( !e)
+	{
+		return true;
+	}
+	for ( unsigned i = share_node_hash( e) & share_mask; share_nodes[i];
+			i = ( i + 1) & share_mask)
+	{
+		if ( share_nodes[i] == e)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool share_equal( const share_key_type &a, const share_key_type &b)
+{
+	if ( a.kind != b.kind || a.value != b.value ||
+			a.symbols[0] != b.symbols[0] || a.symbols[1] != b.symbols[1] ||
+			a.children[0] != b.children[0] || a.children[1] != b.children[1] ||
+			a.children[2] != b.children[2])
+	{
+		return false;
+	}
+	if ( !a.list || !b.list)
+	{
+		return a.list == b.list;
+	}
+	if ( a.list->len() != b.list->len())
+	{
+		return false;
+	}
+	for ( int i = a.list->first(); a.list->more( i); i = a.list->next( i))
+	{
+		if ( a.list->nth( i) != b.list->nth( i))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void share_note( Expression e)
+{
+	unsigned i = share_node_hash( e) & share_mask;
+	while ( share_nodes[i])
+	{
+		i = ( i + 1) & share_mask;
+	}
+	share_nodes[i] = e;
+}
+
+static void share_grow()
+{
+	share_slot_type *old = share_slots;
+	unsigned old_size = share_mask + 1;
+
+	share_mask = old_size * 2 - 1;
+	share_slots = ( share_slot_type *) calloc( share_mask + 1, sizeof( share_slot_type));
+	free( share_nodes);
+	share_nodes = ( Expression *) calloc( share_mask + 1, sizeof( Expression));
+	if ( !share_slots || !share_nodes)
+	{
+		abort();
+	}
+	for ( unsigned i = 0; i < old_size; ++i)
+	{
+		if ( old[i].node)
+		{
+			unsigned j = old[i].hash & share_mask;
+			while ( share_slots[j].node)
+			{
+				j = ( j + 1) & share_mask;
+			}
+			share_slots[j] = old[i];
+			share_note( old[i].node);
+		}
+	}
+	free( old);
+}
+
+static bool share_find( const share_key_type &key)
+{
+	share_pending = NULL;
+	if ( share_on <= 0)
+	{
+		return false;
+	}
+	++share_lookups;
+
+	if ( key.symbols[0] == SELF_TYPE_sym || key.symbols[1] == SELF_TYPE_sym)
+	{
+		return false;
+	}
+
+	unsigned h = share_mix( share_mix( 2166136261u, key.kind), key.value);
+	for ( int i = 0; i < 2; ++i)
+	{
+		h = share_mix( h, share_address( key.symbols[i]));
+	}
+	for ( int i = 0; i < 3; ++i)
+	{
+		if ( !share_closed( key.children[i]))
+		{
+			return false;
+		}
+		h = share_mix( h, share_address( key.children[i]));
+	}
+	if ( key.list)
+	{
+		for ( int i = key.list->first(); key.list->more( i); i = key.list->next( i))
+		{
+			Expression e = key.list->nth( i);
+			if ( !share_closed( e))
+			{
+				return false;
+			}
+			h = share_mix( h, share_address( e));
+		}
+	}
+
+	for ( unsigned i = h & share_mask; ; i = ( i + 1) & share_mask)
+	{
+		share_slot_type *slot = &share_slots[i];
+		if ( !slot->node)
+		{
+			slot->hash = h;
+			slot->key = key;
+			share_pending = slot;
+			return false;
+		}
+		if ( slot->hash == h && share_equal( slot->key, key))
+		{
+			++share_hits;
+			share_hit = slot->node;
+			return true;
+		}
+	}
+}
+
+/* Fills in the slot share_find() left for e, if it left one. */
+static Expression share_add( Expression e)
+{
+	if ( share_pending)
+	{
+		share_pending->node = e;
+		share_pending = NULL;
+		share_note( e);
+
+		if ( ++share_used * 2 > share_mask)
+		{
+			share_grow();
+		}
+	}
+	return e;
+}
+
+static void share_start()
+{
+	char *mode = getenv( "COOL_PARSE_SHARE");
+	share_on = mode && atoi( mode) > 0;
+	if ( share_on)
+	{
+		share_mask = 1023;
+		share_slots = ( share_slot_type *) calloc( share_mask + 1, sizeof( share_slot_type));
+		share_nodes = ( Expression *) calloc( share_mask + 1, sizeof( Expression));
+		if ( !share_slots || !share_nodes)
+		{
+			abort();
+		}
+	}
+}
+
+/*
+ * Recursive-descent parser.
+ * COOL_PARSE_BACKEND=descent parses with the code below instead of the
+ * bison tables: recursive descent for classes and features, precedence
+ * climbing for expressions.  It reads the same tokens through
+ * parse_yylex(), one lookahead at a time and only when it needs one, and
+ * builds the same tree: each node gets the line of the first token of
+ * its construct, which is what YYLLOC_DEFAULT gives the grammar's.
+ *
+ * Syntax errors come out the same too.  The generated parser recovers
+ * at the innermost construct with an error production that is still
+ * open; here that is the innermost caller that recovers, one of
+ * descent_let(), descent_block(), descent_class() (for features) and
+ * descent_parse() (for classes).  Each drops tokens up to the one its
+ * production wants after `error', and as in bison, no error is
+ * reported until three tokens have been shifted since the last one.
+ */
+#define DESCENT_EMPTY -2	/* no lookahead read */
+
+/* The precedence declarations, lowest first. */
+enum descent_prec_type
+{
+	DESCENT_PREC_NONE,
+	DESCENT_PREC_IN,
+	DESCENT_PREC_ASSIGN,
+	DESCENT_PREC_NOT,
+	DESCENT_PREC_COMPARE,	/* nonassoc */
+	DESCENT_PREC_SUM,
+	DESCENT_PREC_PRODUCT,
+	DESCENT_PREC_ISVOID,
+	DESCENT_PREC_NEG,
+	DESCENT_PREC_AT,
+	DESCENT_PREC_DOT
+};
+
+static struct
+{
+	int token;	/* the lookahead, or DESCENT_EMPTY */
+	YYSTYPE val;
+	int line;
+
+	int errstatus;	/* as yyerrstatus: shifts until errors are reported */
+	bool aborted;	/* the input ended while recovering */
+} descent;
+
+static int descent_peek()
+{
+	if ( descent.token == DESCENT_EMPTY)
+	{
+		descent.token = parse_yylex();
+		descent.val = cool_yylval;
+		descent.line = curr_lineno;
+	}
+	return descent.token;
+}
+
+static YYSTYPE descent_shift()
+{
+	descent_peek();
+	descent.token = DESCENT_EMPTY;
+	if ( descent.errstatus > 0)
+	{
+		--descent.errstatus;
+	}
+	return descent.val;
+}
+
+/*
+ * A syntax error at the lookahead.  It returns NULL for the callers to
+ * pass up to the one that recovers.
+ */
+static void *descent_error()
+{
+	if ( descent.errstatus == 0)
+	{
+		parse_error( "syntax error", descent.token);
+	}
+	descent.errstatus = 3;
+	return NULL;
+}
+
+static bool descent_expect( int token)
+{
+	if ( descent_peek() != token)
+	{
+		descent_error();
+		return false;
+	}
+	descent_shift();
+	return true;
+}
+
+static Symbol descent_expect_symbol( int token)
+{
+	if ( descent_peek() != token)
+	{
+		return ( Symbol) descent_error();
+	}
+	return descent_shift().symbol;
+}
+
+/*
+ * Drops tokens up to the next sync or sync2 and shifts it.  Returns
+ * that token, or 0 if the input ends first, which aborts the parse.
+ */
+static int descent_recover( int sync, int sync2 = DESCENT_EMPTY)
+{
+	while ( !descent.aborted && descent_peek() != sync && descent.token != sync2)
+	{
+		if ( descent.token == 0)
+		{
+			descent.aborted = true;
+		}
+		descent.token = DESCENT_EMPTY;
+	}
+	if ( descent.aborted)
+	{
+		return 0;
+	}
+	int token = descent.token;
+	descent_shift();
+	return token;
+}
+
+static Expression descent_expr( int prec);
+
+/* The arguments of a dispatch, after its '('. */
+static Expressions descent_actuals()
+{
+	if ( descent_peek() == ')')
+	{
+		descent_shift();
+		return nil_Expressions();
+	}
+
+	Expressions actuals = NULL;
+	for ( ;;)
+	{
+		Expression e = descent_expr( DESCENT_PREC_NONE);
+		if ( !e)
+		{
+			return NULL;
+		}
+		actuals = actuals ? append_Expressions( actuals, single_Expressions( e)) :
+			single_Expressions( e);
+
+		if ( descent_peek() != ',')
+		{
+			return descent_expect( ')') ? actuals : NULL;
+		}
+		descent_shift();
+	}
+}
+
+/*
+ * let_expression, after LET or after one of its own ','s.  An error
+ * anywhere in it, the body included, is recovered from here.
+ */
+static Expression descent_let()
+{
+	int line = ( descent_peek(), descent.line);
+	Symbol name = descent_expect_symbol( OBJECTID);
+	Symbol type = name && descent_expect( ':') ? descent_expect_symbol( TYPEID) : NULL;
+	if ( type)
+	{
+		Expression init = NULL;
+		bool ok = true;
+		if ( descent_peek() == ASSIGN)
+		{
+			descent_shift();
+			init = descent_expr( DESCENT_PREC_NONE);
+			ok = init != NULL;
+		}
+
+		Expression body = NULL;
+		if ( ok && descent_peek() == ',')
+		{
+			descent_shift();
+			body = descent_let();
+			if ( !body)
+			{
+				return NULL;
+			}
+		}
+		else if ( ok && descent_peek() == IN)
+		{
+			descent_shift();
+			body = descent_expr( DESCENT_PREC_IN);
+		}
+		else if ( ok)
+		{
+			descent_error();
+		}
+
+		if ( body)
+		{
+			node_lineno = line;
+			return share_let( name, type, init ? init : share_no_expr(), body);
+		}
+	}
+
+	// error ',' let_expression | error IN expr
+	for ( ;;)
+	{
+		switch ( descent_recover( ',', IN))
+		{
+			case ',':
+				return descent_let();
+			case IN:
+			{
+				Expression body = descent_expr( DESCENT_PREC_IN);
+				if ( body)
+				{
+					return body;
+				}
+				break;
+			}
+			default:
+				return NULL;
+		}
+	}
+}
+
+/* A block, from its '{'. */
+static Expression descent_block()
+{
+	int line = descent.line;
+	descent_shift();
+
+	Expressions body = NULL;
+	do
+	{
+		Expression e = descent_expr( DESCENT_PREC_NONE);
+		if ( e && descent_expect( ';'))
+		{
+			body = body ? append_Expressions( body, single_Expressions( e)) :
+				single_Expressions( e);
+		}
+		else if ( descent_recover( ';'))
+		{
+			// error ';'
+			body = body ? body : nil_Expressions();
+		}
+		else
+		{
+			return NULL;
+		}
+	}
+	while ( descent_peek() != '}');
+	descent_shift();
+
+	node_lineno = line;
+	return share_block( body);
+}
+
+/* A case, from its CASE. */
+static Expression descent_case()
+{
+	int line = descent.line;
+	descent_shift();
+
+	Expression e = descent_expr( DESCENT_PREC_NONE);
+	if ( !e || !descent_expect( OF))
+	{
+		return NULL;
+	}
+
+	Cases cases = NULL;
+	do
+	{
+		int branch_line = ( descent_peek(), descent.line);
+		Symbol name = descent_expect_symbol( OBJECTID);
+		Symbol type = name && descent_expect( ':') ? descent_expect_symbol( TYPEID) : NULL;
+		if ( !type || !descent_expect( DARROW))
+		{
+			return NULL;
+		}
+		Expression body = descent_expr( DESCENT_PREC_NONE);
+		if ( !body || !descent_expect( ';'))
+		{
+			return NULL;
+		}
+
+		node_lineno = branch_line;
+		Case c = branch( name, type, body);
+		cases = cases ? append_Cases( cases, single_Cases( c)) : single_Cases( c);
+	}
+	while ( descent_peek() != ESAC);
+	descent_shift();
+
+	node_lineno = line;
+	return typcase( e, cases);
+}
+
+/* An expression up to its first infix operator. */
+static Expression descent_operand()
+{
+	int token = descent_peek();
+	int line = descent.line;
+	YYSTYPE val;
+
+	switch ( token)
+	{
+		case OBJECTID:
+		{
+			val = descent_shift();
+			if ( descent_peek() == ASSIGN)
+			{
+				descent_shift();
+				Expression e = descent_expr( DESCENT_PREC_ASSIGN);
+				if ( !e)
+				{
+					return NULL;
+				}
+				node_lineno = line;
+				return assign( val.symbol, e);
+			}
+			if ( descent_peek() == '(')
+			{
+				descent_shift();
+				Expressions actuals = descent_actuals();
+				if ( !actuals)
+				{
+					return NULL;
+				}
+				node_lineno = line;
+				return share_dispatch( object( self_sym), val.symbol, actuals);
+			}
+			node_lineno = line;
+			return object( val.symbol);
+		}
+		case INT_CONST:
+			val = descent_shift();
+			node_lineno = line;
+			return share_int_const( val.symbol);
+		case STR_CONST:
+			val = descent_shift();
+			node_lineno = line;
+			return share_string_const( val.symbol);
+		case BOOL_CONST:
+			val = descent_shift();
+			node_lineno = line;
+			return share_bool_const( val.boolean);
+		case IF:
+		{
+			descent_shift();
+			Expression pred = descent_expr( DESCENT_PREC_NONE);
+			Expression then_exp = pred && descent_expect( THEN) ?
+				descent_expr( DESCENT_PREC_NONE) : NULL;
+			Expression else_exp = then_exp && descent_expect( ELSE) ?
+				descent_expr( DESCENT_PREC_NONE) : NULL;
+			if ( !else_exp || !descent_expect( FI))
+			{
+				return NULL;
+			}
+			node_lineno = line;
+			return share_cond( pred, then_exp, else_exp);
+		}
+		case WHILE:
+		{
+			descent_shift();
+			Expression pred = descent_expr( DESCENT_PREC_NONE);
+			Expression body = pred && descent_expect( LOOP) ?
+				descent_expr( DESCENT_PREC_NONE) : NULL;
+			if ( !body || !descent_expect( POOL))
+			{
+				return NULL;
+			}
+			node_lineno = line;
+			return share_loop( pred, body);
+		}
+		case '{':
+			return descent_block();
+		case LET:
+			descent_shift();
+			return descent_let();
+		case CASE:
+			return descent_case();
+		case NEW:
+		{
+			descent_shift();
+			Symbol type = descent_expect_symbol( TYPEID);
+			if ( !type)
+			{
+				return NULL;
+			}
+			node_lineno = line;
+			return share_new_( type);
+		}
+		case ISVOID:
+		case '~':
+		case NOT:
+		{
+			descent_shift();
+			Expression e = descent_expr( token == ISVOID ? DESCENT_PREC_ISVOID :
+					token == '~' ? DESCENT_PREC_NEG : DESCENT_PREC_NOT);
+			if ( !e)
+			{
+				return NULL;
+			}
+			node_lineno = line;
+			return token == ISVOID ? share_isvoid( e) :
+				token == '~' ? share_neg( e) : share_comp( e);
+		}
+		case '(':
+		{
+			descent_shift();
+			Expression e = descent_expr( DESCENT_PREC_NONE);
+			return e && descent_expect( ')') ? e : NULL;
+		}
+		default:
+			return ( Expression) descent_error();
+	}
+}
+
+static int descent_infix_prec( int token)
+{
+	switch ( token)
+	{
+		case LE:
+		case '<':
+		case '=':
+			return DESCENT_PREC_COMPARE;
+		case '+':
+		case '-':
+			return DESCENT_PREC_SUM;
+		case '*':
+		case '/':
+			return DESCENT_PREC_PRODUCT;
+		case '@':
+			return DESCENT_PREC_AT;
+		case '.':
+			return DESCENT_PREC_DOT;
+		default:
+			return DESCENT_PREC_NONE;
+	}
+}
+
+/*
+ * An expression whose infix operators all bind tighter than prec.
+ * Every node built here starts at the first token of the operand.
+ */
+static Expression descent_expr( int prec)
+{
+	int line = ( descent_peek(), descent.line);
+	Expression e = descent_operand();
+	bool compared = false;
+
+	while ( e)
+	{
+		int token = descent_peek();
+		int token_prec = descent_infix_prec( token);
+		if ( token_prec <= prec)
+		{
+			break;
+		}
+		if ( token_prec == DESCENT_PREC_COMPARE && compared)
+		{
+			return ( Expression) descent_error();
+		}
+		compared = token_prec == DESCENT_PREC_COMPARE;
+		descent_shift();
+
+		if ( token == '.' || token == '@')
+		{
+			Symbol type = NULL;
+			if ( token == '@')
+			{
+				type = descent_expect_symbol( TYPEID);
+				if ( !type || !descent_expect( '.'))
+				{
+					return NULL;
+				}
+			}
+			Symbol name = descent_expect_symbol( OBJECTID);
+			Expressions actuals = name && descent_expect( '(') ? descent_actuals() : NULL;
+			if ( !actuals)
+			{
+				return NULL;
+			}
+			node_lineno = line;
+			e = type ? share_static_dispatch( e, type, name, actuals) :
+				share_dispatch( e, name, actuals);
+			continue;
+		}
+
+		Expression rhs = descent_expr( token_prec);
+		if ( !rhs)
+		{
+			return NULL;
+		}
+		node_lineno = line;
+		switch ( token)
+		{
+			case '+': e = share_plus( e, rhs); break;
+			case '-': e = share_sub( e, rhs); break;
+			case '*': e = share_mul( e, rhs); break;
+			case '/': e = share_divide( e, rhs); break;
+			case '<': e = share_lt( e, rhs); break;
+			case LE: e = share_leq( e, rhs); break;
+			default: e = share_eq( e, rhs); break;
+		}
+	}
+	return e;
+}
+
+/* A feature, from its name. */
+static Feature descent_feature()
+{
+	int line = descent.line;
+	Symbol name = descent_shift().symbol;
+
+	if ( descent_peek() == ':')
+	{
+		descent_shift();
+		Symbol type = descent_expect_symbol( TYPEID);
+		if ( !type)
+		{
+			return NULL;
+		}
+		Expression init = NULL;
+		if ( descent_peek() == ASSIGN)
+		{
+			descent_shift();
+			init = descent_expr( DESCENT_PREC_NONE);
+			if ( !init)
+			{
+				return NULL;
+			}
+		}
+		if ( !descent_expect( ';'))
+		{
+			return NULL;
+		}
+		node_lineno = line;
+		return attr( name, type, init ? init : no_expr());
+	}
+
+	if ( !descent_expect( '('))
+	{
+		return NULL;
+	}
+	Formals formals = NULL;
+	if ( descent_peek() == ')')
+	{
+		formals = nil_Formals();
+	}
+	else
+	{
+		for ( ;;)
+		{
+			int formal_line = ( descent_peek(), descent.line);
+			Symbol formal_name = descent_expect_symbol( OBJECTID);
+			Symbol formal_type = formal_name && descent_expect( ':') ?
+				descent_expect_symbol( TYPEID) : NULL;
+			if ( !formal_type)
+			{
+				return NULL;
+			}
+			node_lineno = formal_line;
+			Formal f = formal( formal_name, formal_type);
+			formals = formals ? append_Formals( formals, single_Formals( f)) :
+				single_Formals( f);
+
+			if ( descent_peek() != ',')
+			{
+				break;
+			}
+			descent_shift();
+		}
+	}
+
+	Symbol type = descent_expect( ')') && descent_expect( ':') ?
+		descent_expect_symbol( TYPEID) : NULL;
+	Expression body = type && descent_expect( '{') ?
+		descent_expr( DESCENT_PREC_NONE) : NULL;
+	if ( !body || !descent_expect( '}') || !descent_expect( ';'))
+	{
+		return NULL;
+	}
+	node_lineno = line;
+	return method( name, formals, type, body);
+}
+
+/*
+ * A class.  Features recover from errors here; from its '{' until its
+ * closing ';', the class itself does too, since bison finds the error
+ * state after the '{' still on its stack.
+ */
+static Class_ descent_class()
+{
+	int line = ( descent_peek(), descent.line);
+	if ( !descent_expect( CLASS))
+	{
+		return NULL;
+	}
+	Symbol name = descent_expect_symbol( TYPEID);
+	if ( !name)
+	{
+		return NULL;
+	}
+	Symbol parent = Object_sym;
+	if ( descent_peek() == INHERITS)
+	{
+		descent_shift();
+		parent = descent_expect_symbol( TYPEID);
+	}
+	if ( !parent || !descent_expect( '{'))
+	{
+		return NULL;
+	}
+
+	Features features = NULL;
+	for ( ;;)
+	{
+		int token = descent_peek();
+		if ( token == OBJECTID)
+		{
+			Feature f = descent_feature();
+			if ( f)
+			{
+				features = features ? append_Features( features, single_Features( f)) :
+					single_Features( f);
+				continue;
+			}
+		}
+		else if ( token == '}')
+		{
+			descent_shift();
+			if ( descent_peek() == ';')
+			{
+				descent_shift();
+				break;
+			}
+			descent_error();
+		}
+		else
+		{
+			descent_error();
+		}
+
+		// error ';'
+		if ( !descent_recover( ';'))
+		{
+			return NULL;
+		}
+		features = features ? features : nil_Features();
+	}
+
+	node_lineno = line;
+	return class_( name, parent, features ? features : nil_Features(), parse_filename());
+}
+
+static int descent_parse()
+{
+	descent.token = DESCENT_EMPTY;
+	descent.errstatus = 0;
+	descent.aborted = false;
+
+	Classes classes = NULL;
+	int line = 0;
+	while ( !classes || descent_peek() != 0)
+	{
+		int class_line = ( descent_peek(), descent.line);
+		Class_ c = descent_class();
+		if ( c)
+		{
+			if ( !classes)
+			{
+				line = class_line;
+			}
+			classes = classes ? append_Classes( classes, single_Classes( c)) :
+				single_Classes( c);
+			parse_class_done( c);
+			parse_results = classes;
+		}
+		else if ( !descent_recover( ';'))
+		{
+			return 1;
+		}
+	}
+
+	node_lineno = line;
+	ast_root = program( classes);
+	return 0;
+}
+
+static double parse_now()
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/*
+ * COOL_PARSE_BACKEND=bison|descent picks the parser, bison by default.
+ * COOL_PARSE_STATS=1 reports the tokens read and the nodes made by
+ * each parse on stderr, and with COOL_PARSE_SHARE=1, how many of the
+ * expressions built were shared.
+ *
+ * With PA4's tree-node.h, which coolc builds with, tree_node takes its nodes
+ * from tree_arena while the arena is open, and each parse opens it; the
+ * driver releases it once the compile is done.  COOL_PARSE_ARENA=0
+ * leaves it closed.  The course's tree.h has no arena, and neither the arena nor
+ * the node counts are built then.
+ */
+int cool_yyparse()
+{
+	static int descent_on = -1;
+	static int stats_on;
+	if ( descent_on < 0)
+	{
+		char *backend = getenv( "COOL_PARSE_BACKEND");
+		descent_on = backend && !strcmp( backend, "descent");
+		char *stats = getenv( "COOL_PARSE_STATS");
+		stats_on = stats && atoi( stats) > 0;
+		share_start();
+		parse_symbols();
+	}
+
+	long tokens = parse_tokens;
+	long lookups = share_lookups;
+	long hits = share_hits;
+	double start = parse_now();
+
+#ifdef TREE_ARENA
+	long nodes = tree_arena::nodes();
+	size_t bytes = tree_arena::bytes();
+	char *mode = getenv( "COOL_PARSE_ARENA");
+	if ( !( mode && atoi( mode) == 0))
+	{
+		tree_arena::open();
+	}
+#endif
+	int result = descent_on ? descent_parse() : parse_yyparse();
+#ifdef TREE_ARENA
+	tree_arena::close();
+#endif
+
+	if ( stats_on)
+	{
+		double secs = parse_now() - start;
+		tokens = parse_tokens - tokens;
+		fprintf( stderr, "parse: %s, %ld tokens in %.3fs, %.0f tokens/s\n",
+				descent_on ? "descent" : "bison", tokens, secs,
+				secs > 0 ? tokens / secs : 0.0);
+#ifdef TREE_ARENA
+		fprintf( stderr, "parse: %ld nodes, %lu bytes\n", tree_arena::nodes() - nodes,
+				( unsigned long) ( tree_arena::bytes() - bytes));
+#endif
+		if ( share_on)
+		{
+			fprintf( stderr, "parse: %ld of %ld expressions shared, %u distinct so far\n",
+					share_hits - hits, share_lookups - lookups, share_used);
+		}
+	}
+	return result;
+}
@@ -0,0 +1,47 @@
+#!/bin/sh
+#
+# Times the parser on a large program with each backend
+# (COOL_PARSE_BACKEND).  COOL_PARSE_STATS adds the parser's own count
+# of tokens per second and of the nodes it allocated.
+#
+#   ./parse-bench.sh [classes] [parser] [lexer]
+#
+# classes  classes to generate (default 50000, about 16 MB of source)
+# parser   parser binary to run (default ./parser)
+# lexer    lexer used once to make the token stream the parser reads
+#          (default ../PA2/lexer)
+
+classes=${1:-50000}
+parser=${2:-./parser}
+lexer=${3:-../PA2/lexer}
+input=${TMPDIR:-/tmp}/parse-bench.$$.cl
+tokens=${TMPDIR:-/tmp}/parse-bench.$$.tokens
+stats=${TMPDIR:-/tmp}/parse-bench.$$.stats
+
+trap 'rm -f "$input" "$tokens" "$stats"' EXIT INT TERM
+
+awk -v n="$classes" 'BEGIN {
+	for ( c = 0; c < n; c++)
+	{
+		printf "class C%d inherits IO {\n  x%d : Int <- %d;\n", c, c, c;
+		printf "  f(a : Int, b : String) : Object { {\n";
+		printf "    let y : Int <- a + %d * 2 in if y < 3 then out_string(b) else self.f(y - 1, \"s%d\") fi;\n", c, c;
+		printf "    while x%d <= 0 loop x%d <- x%d + 1 pool;\n", c, c, c;
+		printf "    case a of i : Int => i; o : Object => o; esac;\n";
+		printf "    new C%d; isvoid x%d; ~a; not true;\n  } };\n};\n", c, c;
+	}
+}' > "$input" || exit 1
+
+"$lexer" "$input" > "$tokens" || exit 1
+
+echo "$classes classes, `wc -c < "$input"` bytes, `wc -l < "$tokens"` tokens"
+for backend in bison descent
+do
+	printf 'COOL_PARSE_BACKEND=%-7s ' $backend
+	start=`date +%s.%N`
+	COOL_PARSE_BACKEND=$backend COOL_PARSE_STATS=1 \
+		"$parser" < "$tokens" 2> "$stats" > /dev/null || exit 1
+	stop=`date +%s.%N`
+	echo "$start $stop" | awk '{ printf "%.3fs\n", $2 - $1 }'
+	sed 's/^/  /' "$stats"
+done
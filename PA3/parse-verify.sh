@@ -0,0 +1,53 @@
+#!/bin/sh
+#
+# Checks that both parser backends (COOL_PARSE_BACKEND) print the same
+# tree and the same errors for every file given.
+#
+#   ./parse-verify.sh [-p parser] [-l lexer] file.cl ...
+#
+# parser   parser binary to run (default ./parser)
+# lexer    lexer that makes the token stream (default ../PA2/lexer)
+#
+# Each file that differs is named with the start of the diff; the exit
+# status is the number of such files (at most 255).
+#
+#   ./parse-verify.sh ../../examples/*.cl ../../tests/PA3/*.cl
+
+parser=./parser
+lexer=../PA2/lexer
+while getopts p:l: opt
+do
+	case $opt in
+	p) parser=$OPTARG ;;
+	l) lexer=$OPTARG ;;
+	*) exit 2 ;;
+	esac
+done
+shift `expr $OPTIND - 1`
+
+dir=${TMPDIR:-/tmp}/parse-verify.$$
+trap 'rm -rf "$dir"' EXIT INT TERM
+mkdir "$dir" || exit 2
+
+checked=0
+failed=0
+for file in "$@"
+do
+	"$lexer" "$file" > "$dir/tokens" || { echo "$file: lexer failed"; failed=`expr $failed + 1`; continue; }
+	for backend in bison descent
+	do
+		COOL_PARSE_BACKEND=$backend "$parser" < "$dir/tokens" > "$dir/$backend" 2>&1
+		echo "exit $?" >> "$dir/$backend"
+	done
+	checked=`expr $checked + 1`
+	if ! cmp -s "$dir/bison" "$dir/descent"
+	then
+		echo "$file: backends differ"
+		diff "$dir/bison" "$dir/descent" | head -10
+		failed=`expr $failed + 1`
+	fi
+done
+
+echo "$checked files, $failed differ"
+[ $failed -gt 255 ] && failed=255
+exit $failed
@@ -0,0 +1,831 @@
+#ifndef AST_BINARY_H_
+#define AST_BINARY_H_
+
+/*
+ *  Binary AST files.
+ *
+ *  An alternative to passing the tree between phases as the text of
+ *  dump_with_types(), which every phase has to lex and parse again.
+ *
+ *    header
+ *    symbols   ast_binary_symbol_type[header.symbols]
+ *    text      header.text bytes, each symbol's characters and a NUL
+ *    nodes     ast_binary_node_type[header.nodes]
+ *    lists     ast_binary_list_type[header.lists]
+ *    children  unsigned[header.children], node indices
+ *
+ *  Every section starts 4-byte aligned, so a mapped file is read in
+ *  place.  Nodes are written children first, so reading is one pass
+ *  forward; the root is the last node.  A node refers to symbols, nodes
+ *  and lists by index, AST_NONE standing for NULL.
+ *
+ *  Header only, and one copy for both phases: PA5 includes it from
+ *  here.  coolc writes the tree after any phase and starts from one
+ *  read back (COOLC_AST_OUT, COOLC_AST_IN); the course's phase mains,
+ *  which aren't in this tree, still pass text.  ast-bench (PA5) times
+ *  this format against dump_with_types().
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+#include <typeinfo>
+#include "cool-tree.h"
+
+#define AST_BINARY_MAGIC "COOLAST1"
+#define AST_NONE 0xffffffffu
+
+enum ast_kind_type
+{
+	AST_PROGRAM, AST_CLASS, AST_METHOD, AST_ATTR, AST_FORMAL, AST_BRANCH,
+	AST_ASSIGN, AST_STATIC_DISPATCH, AST_DISPATCH, AST_COND, AST_LOOP,
+	AST_TYPCASE, AST_BLOCK, AST_LET, AST_PLUS, AST_SUB, AST_MUL,
+	AST_DIVIDE, AST_NEG, AST_LT, AST_EQ, AST_LEQ, AST_COMP, AST_INT_CONST,
+	AST_BOOL_CONST, AST_STRING_CONST, AST_NEW, AST_ISVOID, AST_NO_EXPR,
+	AST_OBJECT,
+	AST_KINDS
+};
+
+enum ast_table_type { AST_ID, AST_INT, AST_STRING };
+
+struct ast_binary_header_type
+{
+	char magic[8];
+	unsigned symbols;
+	unsigned text;
+	unsigned nodes;
+	unsigned lists;
+	unsigned children;
+};
+
+struct ast_binary_symbol_type
+{
+	unsigned table;	/* ast_table_type */
+	unsigned offset;	/* into text */
+	unsigned len;
+};
+
+/*
+ * field[] holds a node's children in constructor order; bool_const keeps
+ * its value in field[0].  type is the symbol semant annotated an
+ * expression with.
+ */
+struct ast_binary_node_type
+{
+	unsigned kind;
+	int line;
+	unsigned type;
+	unsigned field[4];
+};
+
+struct ast_binary_list_type
+{
+	unsigned first;	/* into children */
+	unsigned count;
+};
+
+/*
+ * What a node can stand for in its parent: each kind is one phylum.
+ */
+enum ast_phylum_type
+{
+	AST_IS_PROGRAM, AST_IS_CLASS, AST_IS_FEATURE, AST_IS_FORMAL, AST_IS_CASE,
+	AST_IS_EXPRESSION
+};
+
+static ast_phylum_type ast_phylum( unsigned kind)
+{
+	switch ( kind)
+	{
+		case AST_PROGRAM:
+			return AST_IS_PROGRAM;
+		case AST_CLASS:
+			return AST_IS_CLASS;
+		case AST_METHOD:
+		case AST_ATTR:
+			return AST_IS_FEATURE;
+		case AST_FORMAL:
+			return AST_IS_FORMAL;
+		case AST_BRANCH:
+			return AST_IS_CASE;
+	}
+	return AST_IS_EXPRESSION;
+}
+
+template <class Elem> struct ast_phylum_of;
+template <> struct ast_phylum_of< Class_> { enum { value = AST_IS_CLASS }; };
+template <> struct ast_phylum_of< Feature> { enum { value = AST_IS_FEATURE }; };
+template <> struct ast_phylum_of< Formal> { enum { value = AST_IS_FORMAL }; };
+template <> struct ast_phylum_of< Case> { enum { value = AST_IS_CASE }; };
+template <> struct ast_phylum_of< Expression> { enum { value = AST_IS_EXPRESSION }; };
+
+/*
+ * typeid() of each kind's node class, in ast_kind_type order.
+ */
+static const std::type_info *ast_kind_info[AST_KINDS] = {
+	&typeid( program_class), &typeid( class__class), &typeid( method_class),
+	&typeid( attr_class), &typeid( formal_class), &typeid( branch_class),
+	&typeid( assign_class), &typeid( static_dispatch_class),
+	&typeid( dispatch_class), &typeid( cond_class), &typeid( loop_class),
+	&typeid( typcase_class), &typeid( block_class), &typeid( let_class),
+	&typeid( plus_class), &typeid( sub_class), &typeid( mul_class),
+	&typeid( divide_class), &typeid( neg_class), &typeid( lt_class),
+	&typeid( eq_class), &typeid( leq_class), &typeid( comp_class),
+	&typeid( int_const_class), &typeid( bool_const_class),
+	&typeid( string_const_class), &typeid( new__class),
+	&typeid( isvoid_class), &typeid( no_expr_class), &typeid( object_class)
+};
+
+static int ast_kind_of( tree_node *node)
+{
+	const std::type_info &info = typeid( *node);
+	for ( int k = 0; k < AST_KINDS; ++k)
+	{
+		if ( ast_kind_info[k] == &info)
+		{
+			return k;
+		}
+	}
+	// type_info objects can be duplicated across shared objects.
+	for ( int k = 0; k < AST_KINDS; ++k)
+	{
+		if ( *ast_kind_info[k] == info)
+		{
+			return k;
+		}
+	}
+	return -1;
+}
+
+class ast_binary_writer_type
+{
+	/*
+	 * Where each symbol went in symbols, by open addressing on the
+	 * pointer.
+	 */
+	struct symbol_slot_type
+	{
+		Symbol sym;
+		unsigned index;
+	};
+	std::vector< symbol_slot_type> slots;
+
+	std::vector< ast_binary_symbol_type> symbols;
+	std::vector< char> text;
+	std::vector< ast_binary_node_type> nodes;
+	std::vector< ast_binary_list_type> lists;
+	std::vector< unsigned> children;
+
+	symbol_slot_type *slot_of( Symbol sym)
+	{
+		size_t mask = slots.size() - 1;
+		size_t i = ( ( size_t) sym >> 4) * 2654435761u & mask;
+		while ( slots[i].sym && slots[i].sym != sym)
+		{
+			i = ( i + 1) & mask;
+		}
+		return &slots[i];
+	}
+
+	void grow()
+	{
+		std::vector< symbol_slot_type> old( slots.size() * 2);
+		old.swap( slots);
+		for ( size_t i = 0; i < old.size(); ++i)
+		{
+			if ( old[i].sym)
+			{
+				*slot_of( old[i].sym) = old[i];
+			}
+		}
+	}
+
+	unsigned symbol( Symbol sym, unsigned table)
+	{
+		if ( !sym)
+		{
+			return AST_NONE;
+		}
+		symbol_slot_type *slot = slot_of( sym);
+		if ( slot->sym)
+		{
+			return slot->index;
+		}
+
+		ast_binary_symbol_type entry;
+		entry.table = table;
+		entry.offset = text.size();
+		entry.len = sym->get_len();
+		text.insert( text.end(), sym->get_string(), sym->get_string() + entry.len);
+		text.push_back( '\0');
+
+		slot->sym = sym;
+		slot->index = symbols.size();
+		symbols.push_back( entry);
+		if ( symbols.size() * 2 > slots.size())
+		{
+			grow();
+		}
+		return symbols.size() - 1;
+	}
+
+	template <class Elem> unsigned list( list_node< Elem> *l)
+	{
+		if ( !l)
+		{
+			return AST_NONE;
+		}
+
+		// Nested lists append to children too, so collect first.
+		std::vector< unsigned> elems;
+		for ( int i = l->first(); l->more( i); i = l->next( i))
+		{
+			elems.push_back( node( l->nth( i)));
+		}
+
+		ast_binary_list_type entry;
+		entry.first = children.size();
+		entry.count = elems.size();
+		children.insert( children.end(), elems.begin(), elems.end());
+		lists.push_back( entry);
+		return lists.size() - 1;
+	}
+
+	unsigned node( tree_node *t);
+
+	public:
+	ast_binary_writer_type()
+	{
+		symbol_slot_type empty = { NULL, 0 };
+		slots.assign( 1024, empty);
+	}
+
+	bool write( Program program, FILE *out);
+};
+
+inline unsigned ast_binary_writer_type::node( tree_node *t)
+{
+	if ( !t)
+	{
+		return AST_NONE;
+	}
+
+	ast_binary_node_type rec;
+	memset( &rec, 0, sizeof( rec));
+	rec.kind = ast_kind_of( t);
+	rec.line = t->get_line_number();
+	rec.type = AST_NONE;
+
+	unsigned *f = rec.field;
+	switch ( rec.kind)
+	{
+		case AST_PROGRAM:
+		{
+			program_class *n = ( program_class *) t;
+			f[0] = list( n->classes);
+			break;
+		}
+		case AST_CLASS:
+		{
+			class__class *n = ( class__class *) t;
+			f[0] = symbol( n->name, AST_ID);
+			f[1] = symbol( n->parent, AST_ID);
+			f[2] = list( n->features);
+			f[3] = symbol( n->filename, AST_STRING);
+			break;
+		}
+		case AST_METHOD:
+		{
+			method_class *n = ( method_class *) t;
+			f[0] = symbol( n->name, AST_ID);
+			f[1] = list( n->formals);
+			f[2] = symbol( n->return_type, AST_ID);
+			f[3] = node( n->expr);
+			break;
+		}
+		case AST_ATTR:
+		{
+			attr_class *n = ( attr_class *) t;
+			f[0] = symbol( n->name, AST_ID);
+			f[1] = symbol( n->type_decl, AST_ID);
+			f[2] = node( n->init);
+			break;
+		}
+		case AST_FORMAL:
+		{
+			formal_class *n = ( formal_class *) t;
+			f[0] = symbol( n->name, AST_ID);
+			f[1] = symbol( n->type_decl, AST_ID);
+			break;
+		}
+		case AST_BRANCH:
+		{
+			branch_class *n = ( branch_class *) t;
+			f[0] = symbol( n->name, AST_ID);
+			f[1] = symbol( n->type_decl, AST_ID);
+			f[2] = node( n->expr);
+			break;
+		}
+		case AST_ASSIGN:
+		{
+			assign_class *n = ( assign_class *) t;
+			f[0] = symbol( n->name, AST_ID);
+			f[1] = node( n->expr);
+			break;
+		}
+		case AST_STATIC_DISPATCH:
+		{
+			static_dispatch_class *n = ( static_dispatch_class *) t;
+			f[0] = node( n->expr);
+			f[1] = symbol( n->type_name, AST_ID);
+			f[2] = symbol( n->name, AST_ID);
+			f[3] = list( n->actual);
+			break;
+		}
+		case AST_DISPATCH:
+		{
+			dispatch_class *n = ( dispatch_class *) t;
+			f[0] = node( n->expr);
+			f[1] = symbol( n->name, AST_ID);
+			f[2] = list( n->actual);
+			break;
+		}
+		case AST_COND:
+		{
+			cond_class *n = ( cond_class *) t;
+			f[0] = node( n->pred);
+			f[1] = node( n->then_exp);
+			f[2] = node( n->else_exp);
+			break;
+		}
+		case AST_LOOP:
+		{
+			loop_class *n = ( loop_class *) t;
+			f[0] = node( n->pred);
+			f[1] = node( n->body);
+			break;
+		}
+		case AST_TYPCASE:
+		{
+			typcase_class *n = ( typcase_class *) t;
+			f[0] = node( n->expr);
+			f[1] = list( n->cases);
+			break;
+		}
+		case AST_BLOCK:
+			f[0] = list( ( ( block_class *) t)->body);
+			break;
+		case AST_LET:
+		{
+			let_class *n = ( let_class *) t;
+			f[0] = symbol( n->identifier, AST_ID);
+			f[1] = symbol( n->type_decl, AST_ID);
+			f[2] = node( n->init);
+			f[3] = node( n->body);
+			break;
+		}
+		case AST_PLUS:
+			f[0] = node( ( ( plus_class *) t)->e1);
+			f[1] = node( ( ( plus_class *) t)->e2);
+			break;
+		case AST_SUB:
+			f[0] = node( ( ( sub_class *) t)->e1);
+			f[1] = node( ( ( sub_class *) t)->e2);
+			break;
+		case AST_MUL:
+			f[0] = node( ( ( mul_class *) t)->e1);
+			f[1] = node( ( ( mul_class *) t)->e2);
+			break;
+		case AST_DIVIDE:
+			f[0] = node( ( ( divide_class *) t)->e1);
+			f[1] = node( ( ( divide_class *) t)->e2);
+			break;
+		case AST_LT:
+			f[0] = node( ( ( lt_class *) t)->e1);
+			f[1] = node( ( ( lt_class *) t)->e2);
+			break;
+		case AST_EQ:
+			f[0] = node( ( ( eq_class *) t)->e1);
+			f[1] = node( ( ( eq_class *) t)->e2);
+			break;
+		case AST_LEQ:
+			f[0] = node( ( ( leq_class *) t)->e1);
+			f[1] = node( ( ( leq_class *) t)->e2);
+			break;
+		case AST_NEG:
+			f[0] = node( ( ( neg_class *) t)->e1);
+			break;
+		case AST_COMP:
+			f[0] = node( ( ( comp_class *) t)->e1);
+			break;
+		case AST_ISVOID:
+			f[0] = node( ( ( isvoid_class *) t)->e1);
+			break;
+		case AST_INT_CONST:
+			f[0] = symbol( ( ( int_const_class *) t)->token, AST_INT);
+			break;
+		case AST_BOOL_CONST:
+			f[0] = ( ( bool_const_class *) t)->val;
+			break;
+		case AST_STRING_CONST:
+			f[0] = symbol( ( ( string_const_class *) t)->token, AST_STRING);
+			break;
+		case AST_NEW:
+			f[0] = symbol( ( ( new__class *) t)->type_name, AST_ID);
+			break;
+		case AST_OBJECT:
+			f[0] = symbol( ( ( object_class *) t)->name, AST_ID);
+			break;
+		case AST_NO_EXPR:
+			break;
+		default:
+			cerr << "ast_binary: unknown node kind" << endl;
+			exit( 1);
+	}
+
+	if ( rec.kind >= AST_ASSIGN)
+	{
+		rec.type = symbol( ( ( Expression) t)->get_type(), AST_ID);
+	}
+
+	nodes.push_back( rec);
+	return nodes.size() - 1;
+}
+
+/*
+ * Writes size bytes and pads them to a multiple of 4.
+ */
+static bool ast_binary_put( FILE *out, const void *data, size_t size)
+{
+	static const char zeros[4] = { 0, 0, 0, 0 };
+	size_t pad = ( 4 - size % 4) % 4;
+	return ( size == 0 || fwrite( data, 1, size, out) == size) &&
+		fwrite( zeros, 1, pad, out) == pad;
+}
+
+template <class T> static bool ast_binary_put( FILE *out, const std::vector< T> &v)
+{
+	return v.empty() || ast_binary_put( out, &v[0], v.size() * sizeof( T));
+}
+
+inline bool ast_binary_writer_type::write( Program program, FILE *out)
+{
+	node( program);
+
+	ast_binary_header_type header;
+	memcpy( header.magic, AST_BINARY_MAGIC, sizeof( header.magic));
+	header.symbols = symbols.size();
+	header.text = text.size();
+	header.nodes = nodes.size();
+	header.lists = lists.size();
+	header.children = children.size();
+
+	return ast_binary_put( out, &header, sizeof( header)) &&
+		ast_binary_put( out, symbols) && ast_binary_put( out, text) &&
+		ast_binary_put( out, nodes) && ast_binary_put( out, lists) &&
+		ast_binary_put( out, children) && fflush( out) == 0;
+}
+
+/*
+ * Writes program to path.  Returns false, with errno set, if it can't.
+ */
+static bool ast_binary_write( Program program, const char *path)
+{
+	FILE *out = fopen( path, "wb");
+	if ( !out)
+	{
+		return false;
+	}
+	ast_binary_writer_type writer;
+	bool ok = writer.write( program, out);
+	return fclose( out) == 0 && ok;
+}
+
+class ast_binary_reader_type
+{
+	const ast_binary_header_type *header;
+	const ast_binary_symbol_type *symbol_recs;
+	const char *text;
+	const ast_binary_node_type *node_recs;
+	const ast_binary_list_type *list_recs;
+	const unsigned *child_recs;
+
+	std::vector< Symbol> symbols;
+	std::vector< tree_node *> nodes;
+	bool bad;	/* an index pointed outside what is there, or at the wrong kind */
+
+	static size_t aligned( size_t size)
+	{
+		return ( size + 3) & ~( size_t) 3;
+	}
+
+	/*
+	 * A tree from the writer has no NULL fields, only expressions
+	 * without a type; anything else that is missing is an error.
+	 */
+	Symbol symbol( unsigned i)
+	{
+		if ( i >= symbols.size())
+		{
+			bad = true;
+			return NULL;
+		}
+		return symbols[i];
+	}
+
+	/*
+	 * Only nodes built before the current one can be referred to, and
+	 * only as what they are: a method's body has to be an expression.
+	 */
+	template <class Elem> Elem node( unsigned i)
+	{
+		if ( i >= nodes.size())
+		{
+			bad = true;
+			return NULL;
+		}
+		if ( ast_phylum( node_recs[i].kind) != ( int) ast_phylum_of< Elem>::value)
+		{
+			bad = true;
+			return NULL;
+		}
+		return ( Elem) nodes[i];
+	}
+
+	template <class Elem> list_node< Elem> *list( unsigned i)
+	{
+		if ( i >= header->lists)
+		{
+			bad = true;
+			return NULL;
+		}
+		const ast_binary_list_type &rec = list_recs[i];
+		list_node< Elem> *l = list_node< Elem>::nil();
+		for ( unsigned c = 0; c < rec.count; ++c)
+		{
+			l = list_node< Elem>::append( l,
+					list_node< Elem>::single( node< Elem>( child_recs[rec.first + c])));
+		}
+		return l;
+	}
+
+	bool section( size_t &at, size_t count, size_t each, size_t size);
+	bool check( const char *base, size_t size);
+	tree_node *build( const ast_binary_node_type &rec);
+
+	public:
+	bool typed;	/* some expression read had a type */
+
+	ast_binary_reader_type() : bad( false), typed( false) {}
+
+	Program read( const char *base, size_t size);
+};
+
+/*
+ * Moves at past a section of count records of each bytes, if the file
+ * holds it.  Nothing here can overflow, whatever the counts say.
+ */
+inline bool ast_binary_reader_type::section( size_t &at, size_t count, size_t each,
+		size_t size)
+{
+	if ( at > size || count > ( size - at) / each)
+	{
+		return false;
+	}
+	at += count * each;
+	if ( size - at < aligned( at) - at)
+	{
+		return false;
+	}
+	at = aligned( at);
+	return true;
+}
+
+/*
+ * The sections have to fit in the file, and every index has to point at
+ * something already there.
+ */
+inline bool ast_binary_reader_type::check( const char *base, size_t size)
+{
+	if ( size < sizeof( *header))
+	{
+		return false;
+	}
+	header = ( const ast_binary_header_type *) base;
+	if ( memcmp( header->magic, AST_BINARY_MAGIC, sizeof( header->magic)) || header->nodes == 0)
+	{
+		return false;
+	}
+
+	size_t at = sizeof( *header);
+	symbol_recs = ( const ast_binary_symbol_type *) ( base + at);
+	if ( !section( at, header->symbols, sizeof( *symbol_recs), size))
+	{
+		return false;
+	}
+	text = base + at;
+	if ( !section( at, header->text, 1, size))
+	{
+		return false;
+	}
+	node_recs = ( const ast_binary_node_type *) ( base + at);
+	if ( !section( at, header->nodes, sizeof( *node_recs), size))
+	{
+		return false;
+	}
+	list_recs = ( const ast_binary_list_type *) ( base + at);
+	if ( !section( at, header->lists, sizeof( *list_recs), size))
+	{
+		return false;
+	}
+	child_recs = ( const unsigned *) ( base + at);
+	if ( !section( at, header->children, sizeof( *child_recs), size))
+	{
+		return false;
+	}
+
+	for ( unsigned i = 0; i < header->symbols; ++i)
+	{
+		const ast_binary_symbol_type &s = symbol_recs[i];
+		if ( s.table > AST_STRING || s.offset >= header->text ||
+				s.len >= header->text - s.offset || text[s.offset + s.len] != '\0')
+		{
+			return false;
+		}
+	}
+	for ( unsigned i = 0; i < header->lists; ++i)
+	{
+		if ( list_recs[i].first > header->children ||
+				list_recs[i].count > header->children - list_recs[i].first)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+inline tree_node *ast_binary_reader_type::build( const ast_binary_node_type &rec)
+{
+	const unsigned *f = rec.field;
+	switch ( rec.kind)
+	{
+		case AST_PROGRAM:
+			return program( list< Class_>( f[0]));
+		case AST_CLASS:
+			return class_( symbol( f[0]), symbol( f[1]), list< Feature>( f[2]), symbol( f[3]));
+		case AST_METHOD:
+			return method( symbol( f[0]), list< Formal>( f[1]), symbol( f[2]), node< Expression>( f[3]));
+		case AST_ATTR:
+			return attr( symbol( f[0]), symbol( f[1]), node< Expression>( f[2]));
+		case AST_FORMAL:
+			return formal( symbol( f[0]), symbol( f[1]));
+		case AST_BRANCH:
+			return branch( symbol( f[0]), symbol( f[1]), node< Expression>( f[2]));
+		case AST_ASSIGN:
+			return assign( symbol( f[0]), node< Expression>( f[1]));
+		case AST_STATIC_DISPATCH:
+			return static_dispatch( node< Expression>( f[0]), symbol( f[1]), symbol( f[2]),
+					list< Expression>( f[3]));
+		case AST_DISPATCH:
+			return dispatch( node< Expression>( f[0]), symbol( f[1]), list< Expression>( f[2]));
+		case AST_COND:
+			return cond( node< Expression>( f[0]), node< Expression>( f[1]), node< Expression>( f[2]));
+		case AST_LOOP:
+			return loop( node< Expression>( f[0]), node< Expression>( f[1]));
+		case AST_TYPCASE:
+			return typcase( node< Expression>( f[0]), list< Case>( f[1]));
+		case AST_BLOCK:
+			return block( list< Expression>( f[0]));
+		case AST_LET:
+			return let( symbol( f[0]), symbol( f[1]), node< Expression>( f[2]), node< Expression>( f[3]));
+		case AST_PLUS:
+			return plus( node< Expression>( f[0]), node< Expression>( f[1]));
+		case AST_SUB:
+			return sub( node< Expression>( f[0]), node< Expression>( f[1]));
+		case AST_MUL:
+			return mul( node< Expression>( f[0]), node< Expression>( f[1]));
+		case AST_DIVIDE:
+			return divide( node< Expression>( f[0]), node< Expression>( f[1]));
+		case AST_NEG:
+			return neg( node< Expression>( f[0]));
+		case AST_LT:
+			return lt( node< Expression>( f[0]), node< Expression>( f[1]));
+		case AST_EQ:
+			return eq( node< Expression>( f[0]), node< Expression>( f[1]));
+		case AST_LEQ:
+			return leq( node< Expression>( f[0]), node< Expression>( f[1]));
+		case AST_COMP:
+			return comp( node< Expression>( f[0]));
+		case AST_INT_CONST:
+			return int_const( symbol( f[0]));
+		case AST_BOOL_CONST:
+			return bool_const( f[0]);
+		case AST_STRING_CONST:
+			return string_const( symbol( f[0]));
+		case AST_NEW:
+			return new_( symbol( f[0]));
+		case AST_ISVOID:
+			return isvoid( node< Expression>( f[0]));
+		case AST_NO_EXPR:
+			return no_expr();
+		case AST_OBJECT:
+			return object( symbol( f[0]));
+	}
+	return NULL;
+}
+
+inline Program ast_binary_reader_type::read( const char *base, size_t size)
+{
+	if ( !check( base, size))
+	{
+		return NULL;
+	}
+
+	symbols.resize( header->symbols);
+	for ( unsigned i = 0; i < header->symbols; ++i)
+	{
+		char *s = ( char *) text + symbol_recs[i].offset;
+		int len = symbol_recs[i].len;
+		switch ( symbol_recs[i].table)
+		{
+			case AST_ID:
+				symbols[i] = idtable.add_string( s, len);
+				break;
+			case AST_INT:
+				symbols[i] = inttable.add_string( s, len);
+				break;
+			default:
+				symbols[i] = stringtable.add_string( s, len);
+				break;
+		}
+	}
+
+	int saved_lineno = node_lineno;
+	nodes.reserve( header->nodes);
+	for ( unsigned i = 0; i < header->nodes && !bad; ++i)
+	{
+		const ast_binary_node_type &rec = node_recs[i];
+		node_lineno = rec.line;
+		tree_node *t = build( rec);
+		if ( !t)
+		{
+			bad = true;
+			break;
+		}
+		if ( rec.kind >= AST_ASSIGN)
+		{
+			( ( Expression) t)->set_type( rec.type == AST_NONE ? NULL : symbol( rec.type));
+			typed = typed || rec.type != AST_NONE;
+		}
+		nodes.push_back( t);
+	}
+	node_lineno = saved_lineno;
+
+	if ( bad || node_recs[header->nodes - 1].kind != AST_PROGRAM)
+	{
+		return NULL;
+	}
+	return ( Program) nodes.back();
+}
+
+/*
+ * Reads the program at path, mapping the file.  Returns NULL if the file
+ * can't be read or isn't a well-formed AST file.  The symbols go into
+ * the string tables.  typed, if given, is set when some expression has
+ * a type, that is, when the tree was written after semant.
+ */
+static Program ast_binary_read( const char *path, bool *typed = NULL)
+{
+	int fd = open( path, O_RDONLY);
+	if ( fd < 0)
+	{
+		return NULL;
+	}
+	struct stat st;
+	if ( fstat( fd, &st) < 0 || st.st_size == 0)
+	{
+		close( fd);
+		return NULL;
+	}
+	void *base = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close( fd);
+	if ( base == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	ast_binary_reader_type reader;
+	Program program = reader.read( ( const char *) base, st.st_size);
+	if ( typed)
+	{
+		*typed = program && reader.typed;
+	}
+	munmap( base, st.st_size);
+	return program;
+}
+
+#endif
@@ -9,48 +9,9 @@
 //////////////////////////////////////////////////////////
 
 
-#include "tree.h"
+#include "tree-node.h"
 #include "cool-tree.handcode.h"
-
-struct class_tree_node_type;
-typedef class_tree_node_type *class_tree_node;
-class Type
-{
-	private:
-	class_tree_node node;
-
-	public:
-	Type( class_tree_node n = NULL);
-	Type( const Type &tn)
-	{
-		node = tn.node;
-	}
-
-	operator bool() const;
-
-	class_tree_node operator->() const
-	{
-		return node;
-	}
-
-	operator class_tree_node() const
-	{
-		return node;
-	}
-
-	friend bool operator==( const Type &a, const Type &b);
-	friend bool operator==( const Type &a, class_tree_node b);
-	friend bool operator==( class_tree_node a, const Type &b);
-
-	friend bool operator<=( const Type &, const Type &);
-
-	friend Type find_type_lca( const Type &, const Type &);
-
-	bool is_sub_type_of( const Type &o)
-	{
-		return *this <= o;
-	}
-};
+#include "semant-tree.h"
 
 // define the class for phylum
 // define simple phylum - Program
@@ -75,11 +36,7 @@ public:
    tree_node *copy()		 { return copy_Class_(); }
    virtual Class_ copy_Class_() = 0;
 
-   virtual void collect_Methods() = 0;
-   virtual bool check_Class_Types() = 0;
-
-   virtual Symbol get_name() const = 0;
-   virtual Symbol get_parent_name() const = 0;
+   Class__SEMANT_EXTRAS
 
 #ifdef Class__EXTRAS
    Class__EXTRAS
@@ -91,15 +48,11 @@ public:
 typedef class Feature_class *Feature;
 
 class Feature_class : public tree_node {
-protected:
-   Type feature_type;
 public:
    tree_node *copy()		 { return copy_Feature(); }
    virtual Feature copy_Feature() = 0;
 
-   virtual void collect_Feature_Types() = 0;
-   virtual bool check_Feature_Types() = 0;
-   virtual bool install_Feature_Types() = 0;
+   Feature_SEMANT_EXTRAS
 
 #ifdef Feature_EXTRAS
    Feature_EXTRAS
@@ -115,9 +68,7 @@ public:
    tree_node *copy()		 { return copy_Formal(); }
    virtual Formal copy_Formal() = 0;
 
-   virtual Type collect_Formal_Type() = 0;
-   virtual bool check_Formal_Type() = 0;
-   virtual void install_Formal_Type() = 0;
+   Formal_SEMANT_EXTRAS
 
 #ifdef Formal_EXTRAS
    Formal_EXTRAS
@@ -129,19 +80,11 @@ public:
 typedef class Expression_class *Expression;
 
 class Expression_class : public tree_node {
-   Type   expr_type;
-   bool   checked;
 public:
    tree_node *copy()		 { return copy_Expression(); }
    virtual Expression copy_Expression() = 0;
 
-   virtual Type do_Check_Expr_Type() = 0;
-   Type get_Expr_Type();
-
-   virtual bool is_no_expr() const
-   {
-	   return false;
-   }
+   Expression_SEMANT_EXTRAS
 
 #ifdef Expression_EXTRAS
    Expression_EXTRAS
@@ -157,8 +100,7 @@ public:
    tree_node *copy()		 { return copy_Case(); }
    virtual Case copy_Case() = 0;
 
-   virtual bool install_Case_Type() = 0;
-   virtual Type check_Case_Type( Type path_type) = 0;
+   Case_SEMANT_EXTRAS
 
 #ifdef Case_EXTRAS
    Case_EXTRAS
@@ -193,8 +135,10 @@ typedef Cases_class *Cases;
 
 
 // define the class for constructors
+// ast-binary.h reads their fields, as a friend.
 // define constructor - program
 class program_class : public Program_class {
+   friend class ast_binary_writer_type;
 protected:
    Classes classes;
 public:
@@ -215,6 +159,7 @@ public:
 
 // define constructor - class_
 class class__class : public Class__class {
+   friend class ast_binary_writer_type;
 protected:
    Symbol name;
    Symbol parent;
@@ -230,18 +175,7 @@ public:
    Class_ copy_Class_();
    void dump(ostream& stream, int n);
 
-   Symbol get_name() const
-   {
-	   return name;
-   }
-
-   Symbol get_parent_name() const
-   {
-	   return parent;
-   }
-
-   void collect_Methods();
-   bool check_Class_Types();
+   class__SEMANT_EXTRAS
 
 #ifdef Class__SHARED_EXTRAS
    Class__SHARED_EXTRAS
@@ -254,6 +188,7 @@ public:
 
 // define constructor - method
 class method_class : public Feature_class {
+   friend class ast_binary_writer_type;
 protected:
    Symbol name;
    Formals formals;
@@ -269,9 +204,7 @@ public:
    Feature copy_Feature();
    void dump(ostream& stream, int n);
 
-   void collect_Feature_Types();
-   bool install_Feature_Types();
-   bool check_Feature_Types();
+   Feature_SHARED_SEMANT_EXTRAS
 
 #ifdef Feature_SHARED_EXTRAS
    Feature_SHARED_EXTRAS
@@ -284,6 +217,7 @@ public:
 
 // define constructor - attr
 class attr_class : public Feature_class {
+   friend class ast_binary_writer_type;
 protected:
    Symbol name;
    Symbol type_decl;
@@ -297,9 +231,7 @@ public:
    Feature copy_Feature();
    void dump(ostream& stream, int n);
 
-   void collect_Feature_Types();
-   bool install_Feature_Types();
-   bool check_Feature_Types();
+   Feature_SHARED_SEMANT_EXTRAS
 
 #ifdef Feature_SHARED_EXTRAS
    Feature_SHARED_EXTRAS
@@ -312,7 +244,7 @@ public:
 
 // define constructor - formal
 class formal_class : public Formal_class {
-   Type ext_type;
+   friend class ast_binary_writer_type;
 protected:
    Symbol name;
    Symbol type_decl;
@@ -324,9 +256,7 @@ public:
    Formal copy_Formal();
    void dump(ostream& stream, int n);
 
-   Type collect_Formal_Type();
-   bool check_Formal_Type();
-   void install_Formal_Type();
+   formal_SEMANT_EXTRAS
 
 #ifdef Formal_SHARED_EXTRAS
    Formal_SHARED_EXTRAS
@@ -339,7 +269,7 @@ public:
 
 // define constructor - branch
 class branch_class : public Case_class {
-   Type id_type;
+   friend class ast_binary_writer_type;
 protected:
    Symbol name;
    Symbol type_decl;
@@ -353,8 +283,7 @@ public:
    Case copy_Case();
    void dump(ostream& stream, int n);
 
-   bool install_Case_Type();
-   Type check_Case_Type( Type path_type);
+   branch_SEMANT_EXTRAS
 
 #ifdef Case_SHARED_EXTRAS
    Case_SHARED_EXTRAS
@@ -367,6 +296,7 @@ public:
 
 // define constructor - assign
 class assign_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Symbol name;
    Expression expr;
@@ -378,7 +308,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -391,6 +321,7 @@ public:
 
 // define constructor - static_dispatch
 class static_dispatch_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression expr;
    Symbol type_name;
@@ -406,7 +337,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -419,6 +350,7 @@ public:
 
 // define constructor - dispatch
 class dispatch_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression expr;
    Symbol name;
@@ -432,7 +364,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -445,6 +377,7 @@ public:
 
 // define constructor - cond
 class cond_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression pred;
    Expression then_exp;
@@ -458,7 +391,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -471,6 +404,7 @@ public:
 
 // define constructor - loop
 class loop_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression pred;
    Expression body;
@@ -482,7 +416,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -495,6 +429,7 @@ public:
 
 // define constructor - typcase
 class typcase_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression expr;
    Cases cases;
@@ -506,7 +441,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -519,6 +454,7 @@ public:
 
 // define constructor - block
 class block_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expressions body;
 public:
@@ -528,7 +464,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -541,6 +477,7 @@ public:
 
 // define constructor - let
 class let_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Symbol identifier;
    Symbol type_decl;
@@ -556,7 +493,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -569,6 +506,7 @@ public:
 
 // define constructor - plus
 class plus_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression e1;
    Expression e2;
@@ -580,7 +518,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -593,6 +531,7 @@ public:
 
 // define constructor - sub
 class sub_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression e1;
    Expression e2;
@@ -604,7 +543,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -617,6 +556,7 @@ public:
 
 // define constructor - mul
 class mul_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression e1;
    Expression e2;
@@ -628,7 +568,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -641,6 +581,7 @@ public:
 
 // define constructor - divide
 class divide_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression e1;
    Expression e2;
@@ -652,7 +593,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -665,6 +606,7 @@ public:
 
 // define constructor - neg
 class neg_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression e1;
 public:
@@ -674,7 +616,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -687,6 +629,7 @@ public:
 
 // define constructor - lt
 class lt_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression e1;
    Expression e2;
@@ -698,7 +641,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -711,6 +654,7 @@ public:
 
 // define constructor - eq
 class eq_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression e1;
    Expression e2;
@@ -722,7 +666,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -735,6 +679,7 @@ public:
 
 // define constructor - leq
 class leq_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression e1;
    Expression e2;
@@ -746,7 +691,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -759,6 +704,7 @@ public:
 
 // define constructor - comp
 class comp_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression e1;
 public:
@@ -768,7 +714,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -781,6 +727,7 @@ public:
 
 // define constructor - int_const
 class int_const_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Symbol token;
 public:
@@ -790,7 +737,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -803,6 +750,7 @@ public:
 
 // define constructor - bool_const
 class bool_const_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Boolean val;
 public:
@@ -812,7 +760,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -825,6 +773,7 @@ public:
 
 // define constructor - string_const
 class string_const_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Symbol token;
 public:
@@ -834,7 +783,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -847,6 +796,7 @@ public:
 
 // define constructor - new_
 class new__class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Symbol type_name;
 public:
@@ -856,7 +806,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -869,6 +819,7 @@ public:
 
 // define constructor - isvoid
 class isvoid_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Expression e1;
 public:
@@ -878,7 +829,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -891,6 +842,7 @@ public:
 
 // define constructor - no_expr
 class no_expr_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
 public:
    no_expr_class() {
@@ -898,12 +850,8 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   bool is_no_expr() const
-   {
-	   return true;
-   }
-
-   Type do_Check_Expr_Type();
+   no_expr_SEMANT_EXTRAS
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -916,6 +864,7 @@ public:
 
 // define constructor - object
 class object_class : public Expression_class {
+   friend class ast_binary_writer_type;
 protected:
    Symbol name;
 public:
@@ -925,7 +874,7 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   Type do_Check_Expr_Type();
+   Expression_SHARED_SEMANT_EXTRAS
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
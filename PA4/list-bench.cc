@@ -0,0 +1,79 @@
+/*
+ *  AST list scaling benchmark.
+ *
+ *  Builds lists the way the parser does, one append_node per element,
+ *  and times the first()/more()/nth() loop semant and cgen run over
+ *  them, for doubling lengths.  With the flattened lists in tree-node.h the
+ *  time per element stays flat; the first pass includes the flattening.
+ *
+ *    list-bench [max-length]
+ *
+ *  Build it next to tree-node.h:
+ *
+ *    g++ -g -O2 -I. -I../../include/PA4 -include tree-node.h \
+ *        list-bench.cc ../../src/PA4/tree.cc -o list-bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "tree-node.h"
+
+struct item_class : public tree_node
+{
+	int value;
+
+	item_class( int v) : value( v) {}
+	tree_node *copy() { return new item_class( value); }
+	void dump( ostream &stream, int n) { stream << pad( n) << value << "\n"; }
+};
+typedef item_class *item;
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static long walk( list_node< item> *l)
+{
+	long sum = 0;
+	for ( int i = l->first(); l->more( i); i = l->next( i))
+	{
+		sum += l->nth( i)->value;
+	}
+	return sum;
+}
+
+int main( int argc, char **argv)
+{
+	int max = argc > 1 ? atoi( argv[1]) : 1 << 20;
+
+	printf( "%10s %12s %12s\n", "length", "first ns/el", "again ns/el");
+	for ( int n = 1024; n <= max; n *= 2)
+	{
+		list_node< item> *l = list_node< item>::nil();
+		for ( int i = 0; i < n; ++i)
+		{
+			l = list_node< item>::append( l, list_node< item>::single( new item_class( i)));
+		}
+
+		double start = now();
+		long sum = walk( l);
+		double first = now() - start;
+
+		start = now();
+		sum -= walk( l);
+		double again = now() - start;
+
+		if ( sum != 0)
+		{
+			fprintf( stderr, "list-bench: passes disagree\n");
+			return 1;
+		}
+		printf( "%10d %12.1f %12.1f\n", n, first * 1e9 / n, again * 1e9 / n);
+	}
+	return 0;
+}
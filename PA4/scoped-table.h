@@ -0,0 +1,222 @@
+#ifndef SCOPED_TABLE_H_
+#define SCOPED_TABLE_H_
+
+/*
+ *  A scoped symbol table with the interface of SymbolTable (symtab.h).
+ *
+ *  SymbolTable keeps a list of scopes, each a list of entries, so a
+ *  lookup searches every entry in scope.  This one keeps the binding
+ *  each symbol has now in one open-addressing hash table, and an undo
+ *  log of what each addid() replaced; exitscope() pops the log back to
+ *  where the scope began and puts those bindings back.  lookup() and
+ *  probe() are one probe each, however deep the scopes.
+ *
+ *  A symbol is hashed by its address, so SYM has to be a pointer, as
+ *  Symbol is.  Entries are removed by shifting the ones after them back
+ *  rather than with tombstones, since lets and cases enter and leave
+ *  scopes all the time.
+ */
+
+#include <stdlib.h>
+#include <vector>
+#include <iostream>
+
+template <class SYM, class DAT>
+class scoped_table_type
+{
+	struct slot_type
+	{
+		SYM sym;	/* NULL when empty */
+		DAT *info;
+		int depth;	/* of the scope it was added in */
+	};
+
+	/* A binding addid() replaced; depth -1 when there was none. */
+	struct undo_type
+	{
+		SYM sym;
+		DAT *info;
+		int depth;
+	};
+
+	std::vector< slot_type> slots;
+	unsigned used;
+	std::vector< undo_type> log;
+	std::vector< size_t> scopes;	/* where each scope starts in log */
+
+	static void fatal( const char *msg)
+	{
+		std::cerr << msg << std::endl;
+		exit( 1);
+	}
+
+	size_t home( SYM s) const
+	{
+		return ( ( size_t) s >> 4) * 2654435761u & ( slots.size() - 1);
+	}
+
+	slot_type *find( SYM s)
+	{
+		size_t mask = slots.size() - 1;
+		size_t i = home( s);
+		while ( slots[i].sym && slots[i].sym != s)
+		{
+			i = ( i + 1) & mask;
+		}
+		return &slots[i];
+	}
+
+	/*
+	 * Empties slot and moves back any later entry of its run that would
+	 * no longer be found past the gap.
+	 */
+	void remove( slot_type *slot)
+	{
+		size_t mask = slots.size() - 1;
+		size_t gap = slot - &slots[0];
+		for ( size_t i = ( gap + 1) & mask; slots[i].sym; i = ( i + 1) & mask)
+		{
+			size_t h = home( slots[i].sym);
+			if ( ( ( i - h) & mask) >= ( ( i - gap) & mask))
+			{
+				slots[gap] = slots[i];
+				gap = i;
+			}
+		}
+		slots[gap].sym = NULL;
+		--used;
+	}
+
+	void grow()
+	{
+		std::vector< slot_type> old( slots.size() * 2);
+		old.swap( slots);
+		for ( size_t i = 0; i < old.size(); ++i)
+		{
+			if ( old[i].sym)
+			{
+				*find( old[i].sym) = old[i];
+			}
+		}
+	}
+
+	public:
+	/*
+	 * Calls so far, for whoever wants to report them.  Only a build
+	 * with -DSEMANT_STATS counts them; otherwise they stay 0.
+	 */
+	struct calls_type
+	{
+		long lookups, probes, addids, enterscopes, exitscopes;
+	};
+	calls_type calls;
+
+	private:
+	static void count( long &n)
+	{
+#ifdef SEMANT_STATS
+		++n;
+#else
+		( void) n;
+#endif
+	}
+
+	public:
+
+	scoped_table_type() : used( 0)
+	{
+		slot_type empty = { NULL, NULL, 0 };
+		slots.assign( 16, empty);
+		calls_type none = { 0, 0, 0, 0, 0 };
+		calls = none;
+	}
+
+	void enterscope()
+	{
+		count( calls.enterscopes);
+		scopes.push_back( log.size());
+	}
+
+	void exitscope()
+	{
+		count( calls.exitscopes);
+		if ( scopes.empty())
+		{
+			fatal( "exitscope: Can't remove scope from an empty symbol table.");
+		}
+		while ( log.size() > scopes.back())
+		{
+			const undo_type &u = log.back();
+			slot_type *slot = find( u.sym);
+			if ( u.depth < 0)
+			{
+				remove( slot);
+			}
+			else
+			{
+				slot->info = u.info;
+				slot->depth = u.depth;
+			}
+			log.pop_back();
+		}
+		scopes.pop_back();
+	}
+
+	void addid( SYM s, DAT *i)
+	{
+		count( calls.addids);
+		if ( scopes.empty())
+		{
+			fatal( "addid: Can't add a symbol without a scope.");
+		}
+		slot_type *slot = find( s);
+		undo_type u = { s, slot->info, slot->sym ? slot->depth : -1 };
+		log.push_back( u);
+		if ( !slot->sym)
+		{
+			slot->sym = s;
+			++used;
+		}
+		slot->info = i;
+		slot->depth = scopes.size();
+		if ( used * 2 > slots.size())
+		{
+			grow();
+		}
+	}
+
+	DAT *lookup( SYM s)
+	{
+		count( calls.lookups);
+		slot_type *slot = find( s);
+		return slot->sym ? slot->info : NULL;
+	}
+
+	DAT *probe( SYM s)
+	{
+		count( calls.probes);
+		if ( scopes.empty())
+		{
+			fatal( "probe: No scope in symbol table.");
+		}
+		slot_type *slot = find( s);
+		return slot->sym && slot->depth == ( int) scopes.size() ? slot->info : NULL;
+	}
+
+	/* The symbols in each scope, innermost first, as SymbolTable prints them. */
+	void dump()
+	{
+		size_t end = log.size();
+		for ( size_t scope = scopes.size(); scope-- > 0; )
+		{
+			std::cerr << "\nScope: \n";
+			for ( size_t i = end; i-- > scopes[scope]; )
+			{
+				std::cerr << "  " << log[i].sym << std::endl;
+			}
+			end = scopes[scope];
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef SEMANT_TREE_H_
+#define SEMANT_TREE_H_
+
+/*
+ *  What semant.cc adds to the tree's classes.
+ *
+ *  The one copy of these declarations: PA4's cool-tree.h expands the
+ *  macros in its classes, and PA5's cool-tree.handcode.h puts them in
+ *  its *_EXTRAS when coolc builds cgen's tree with semant.cc in it.
+ *  Each macro leaves the class in a public section, as the *_EXTRAS
+ *  that follow it expect.
+ *
+ *  The course's PA4 handcode already declares Program's semant(), so
+ *  only PA5 uses the two Program macros.
+ */
+
+struct class_tree_node_type;
+typedef class_tree_node_type *class_tree_node;
+struct check_frame_type;
+class Type
+{
+	private:
+	class_tree_node node;
+
+	public:
+	Type( class_tree_node n = NULL);
+	Type( const Type &tn)
+	{
+		node = tn.node;
+	}
+
+	operator bool() const;
+
+	class_tree_node operator->() const
+	{
+		return node;
+	}
+
+	operator class_tree_node() const
+	{
+		return node;
+	}
+
+	friend bool operator==( const Type &a, const Type &b);
+	friend bool operator==( const Type &a, class_tree_node b);
+	friend bool operator==( class_tree_node a, const Type &b);
+
+	friend bool operator<=( const Type &, const Type &);
+
+	friend Type find_type_lca( const Type &, const Type &);
+
+	bool is_sub_type_of( const Type &o)
+	{
+		return *this <= o;
+	}
+};
+
+/*
+ * Whether an expression has been checked.  Expression_class's
+ * constructor is the handcode's, so the flag clears itself.
+ */
+class semant_flag_type
+{
+	bool set;
+
+	public:
+	semant_flag_type() : set( false) {}
+
+	operator bool() const
+	{
+		return set;
+	}
+
+	semant_flag_type &operator=( bool b)
+	{
+		set = b;
+		return *this;
+	}
+};
+
+#define Program_SEMANT_EXTRAS			\
+virtual void semant() = 0;
+
+#define program_SEMANT_EXTRAS			\
+void semant();
+
+#define Class__SEMANT_EXTRAS			\
+virtual void collect_Methods() = 0;		\
+virtual void install_Class_Types() = 0;		\
+virtual bool check_Class_Types() = 0;		\
+virtual Symbol get_name() const = 0;		\
+virtual Symbol get_parent_name() const = 0;
+
+#define class__SEMANT_EXTRAS			\
+Symbol get_name() const { return name; }	\
+Symbol get_parent_name() const { return parent; } \
+void collect_Methods();				\
+void install_Class_Types();			\
+bool check_Class_Types();
+
+#define Feature_SEMANT_EXTRAS			\
+protected:					\
+Type feature_type;				\
+public:						\
+virtual void collect_Feature_Types() = 0;	\
+virtual bool check_Feature_Types() = 0;		\
+virtual bool install_Feature_Types() = 0;
+
+#define Feature_SHARED_SEMANT_EXTRAS		\
+void collect_Feature_Types();			\
+bool install_Feature_Types();			\
+bool check_Feature_Types();
+
+#define Formal_SEMANT_EXTRAS			\
+virtual Type collect_Formal_Type() = 0;		\
+virtual bool check_Formal_Type() = 0;		\
+virtual void install_Formal_Type() = 0;
+
+#define formal_SEMANT_EXTRAS			\
+private:					\
+Type ext_type;					\
+public:						\
+Type collect_Formal_Type();			\
+bool check_Formal_Type();			\
+void install_Formal_Type();
+
+#define Case_SEMANT_EXTRAS			\
+virtual bool install_Case_Type() = 0;		\
+virtual Expression enter_Case_Scope() = 0;	\
+virtual void exit_Case_Scope() = 0;
+
+#define branch_SEMANT_EXTRAS			\
+private:					\
+Type id_type;					\
+public:						\
+bool install_Case_Type();			\
+Expression enter_Case_Scope();			\
+void exit_Case_Scope();
+
+#define Expression_SEMANT_EXTRAS		\
+private:					\
+Type expr_type;					\
+semant_flag_type checked;			\
+public:						\
+virtual Expression check_Expr_Step( check_frame_type &f) = 0; \
+Type get_Expr_Type();				\
+virtual bool is_no_expr() const { return false; }
+
+#define Expression_SHARED_SEMANT_EXTRAS		\
+Expression check_Expr_Step( check_frame_type &f);
+
+#define no_expr_SEMANT_EXTRAS			\
+bool is_no_expr() const { return true; }
+
+#endif
@@ -3,6 +3,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+#include <vector>
+#include <sys/time.h>
 #include "semant.h"
 #include "utilities.h"
 
@@ -12,7 +15,8 @@ extern char *curr_filename;
 
 symtable_type *class_table;
 symtable_type *var_table;
-method_table_type *method_table;
+semant_stats_type semant_stats;
+class_tree_node collecting_class;
 ClassTable *cls_table;
 
 //////////////////////////////////////////////////////////////////////
@@ -113,30 +117,38 @@ Type lookup_install_type( Symbol name, Class_ class_ = NULL, Type father_type =
 	   return type;
 }
 
+/*
+ * The shallowest class on the Euler tour between x and y is their LCA
+ * when they share a root; when they don't, it is some root that holds
+ * neither, and there is none.
+ */
 class_tree_node find_class_lca( class_tree_node x, class_tree_node y)
 {
+	semant_count( semant_stats.lca_queries);
 	if ( !x || !y)
 	{
 		return NULL;
 	}
-
-	int depth = x->depth < y->depth ? x->depth : y->depth;
-	while ( x && x->depth != depth)
+	if ( x == y)
 	{
-		x = x->father;
+		return x;
 	}
-	while ( y && y->depth != depth)
+	if ( x->tour_at < 0 || y->tour_at < 0)
 	{
-		y = y->father;
+		return NULL;
 	}
 
-	while ( x && y && x != y)
-	{
-		x = x->father;
-		y = y->father;
-	}
+	typedef class_tree_node_type node_type;
+	size_t from = x->tour_at < y->tour_at ? x->tour_at : y->tour_at;
+	size_t to = ( x->tour_at < y->tour_at ? y->tour_at : x->tour_at) + 1;
+	int k = node_type::lca_log[to - from];
+	size_t row = k * node_type::tour.size();
+	class_tree_node a = node_type::lca_table[row + from];
+	class_tree_node b = node_type::lca_table[row + to - ( 1 << k)];
+	class_tree_node lca = a->depth <= b->depth ? a : b;
 
-	return x ? y : NULL;
+	return lca->enter <= x->enter && x->enter <= lca->leave
+		&& lca->enter <= y->enter && y->enter <= lca->leave ? lca : NULL;
 }
 
 class_tree_node union_set( class_tree_node first, class_tree_node second)
@@ -231,82 +243,310 @@ Type find_type_lca( const Type &a, const Type &b)
 	return find_class_lca( xa, xb);
 }
 
+/*
+ * Whether t, the method this one overrides, has the same return type
+ * and formal types.  t may have formals past this one's; they are not
+ * looked at.
+ */
 bool class_method_type::same_method( class_method t) const
 {
-	if ( !t || t->type != type)
+	if ( !t || t->formals < formals)
 	{
 		return false;
 	}
 
-	return next ? next->same_method( t->next) : true;
+	for ( int i = 0; i <= formals; ++i)
+	{
+		if ( t->types[i] != types[i])
+		{
+			return false;
+		}
+	}
+	return true;
 }
 
-ClassTable::ClassTable(Classes classes) : semant_errors(0) , error_stream(cerr) {
-	cls_table = this;
-	class_table = &symtable;
-	var_table = &vartable;
-
-	class_table->enterscope();
+void method_cache_type::add( Symbol name, class_method method)
+{
+	if ( slots.empty())
+	{
+		slot_type empty = { NULL, NULL };
+		slots.assign( 8, empty);
+	}
 
-	install_basic_classes();
-	class_tree_node root = class_table->probe( Object);
+	slot_type *slot = find( name);
+	if ( !slot->name)
+	{
+		slot->name = name;
+		++used;
+	}
+	slot->method = method;
 
-	if ( !root)
+	if ( used * 2 > slots.size())
 	{
-		// Find bug: No root !
-		semant_error() << "BUG: Could not find object class." << endl;
-		return;
+		std::vector< slot_type> old( slots.size() * 2);
+		old.swap( slots);
+		for ( size_t i = 0; i < old.size(); ++i)
+		{
+			if ( old[i].name)
+			{
+				*find( old[i].name) = old[i];
+			}
+		}
 	}
+}
 
-	int cnt = root->find_set()->set_size;
-	for ( int i = classes->first(); classes->more( i); i = classes->next( i))
+/*
+ * Every method there is, by name: the last one collected, from which
+ * the homonyms lead to the rest.
+ */
+static method_cache_type methods_by_name;
+
+
+/*
+ * COOL_SEMANT_STATS=file writes what semant counted and timed to file,
+ * as JSON, when the process exits, whether the program had errors or
+ * not; "-" writes it to stderr.  The times are taken in any build, the
+ * counts only in one with -DSEMANT_STATS (see semant_count()).
+ */
+static const char *stats_file;
+static std::vector< double> install_secs, check_secs;	/* by enter */
+
+static double stats_now()
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* Adds the time since start to c's entry of secs, and returns the time. */
+static double stats_lap( std::vector< double> &secs, class_tree_node c, double start)
+{
+	double now = stats_now();
+	if ( c->enter >= 0 && c->enter < ( int) secs.size())
 	{
-		Class_ cur = classes->nth(i);
-		class_tree_node ct_node = lookup_install_type( cur->get_name());
+		secs[c->enter] += now - start;
+	}
+	return now;
+}
 
-		if ( ct_node->contain == NULL)
+static void json_string( FILE *out, const char *s)
+{
+	putc( '"', out);
+	for ( ; *s; ++s)
+	{
+		unsigned char c = *s;
+		if ( c == '"' || c == '\\')
 		{
-			ct_node->set_contain( cur);
+			fprintf( out, "\\%c", c);
 		}
-		else
+		else if ( c < 0x20)
 		{
-			// Find error: Redefinition of class
-			semant_error( cur) << "Redefinition of Class " << cur->get_name() << endl;
-			return;
+			fprintf( out, "\\u%04x", c);
 		}
-
-		class_tree_node father_node = lookup_install_type( cur->get_parent_name());
-		if ( father_node == ct_node)
+		else
 		{
-			semant_error( cur) << "Class " << cur->get_name() <<
-				" count not be the super class of itself." << endl;
+			putc( c, out);
 		}
+	}
+	putc( '"', out);
+}
 
-		if ( father_node == Bool_type || father_node == Int_type || father_node == Str_type)
-		{
-			semant_error( cur) << "It's illegal to inherit from Class " <<
-				cur->get_parent_name() << endl;
-		}
+#ifdef SEMANT_STATS
+static void json_calls( FILE *out, const char *name, const symtable_type::calls_type &c)
+{
+	fprintf( out, "  \"%s\": {\"lookups\": %ld, \"probes\": %ld, \"addids\": %ld, "
+			"\"enterscopes\": %ld, \"exitscopes\": %ld},\n",
+			name, c.lookups, c.probes, c.addids, c.enterscopes, c.exitscopes);
+}
+#endif
 
-		if ( father_node == Self_type)
+/* Runs at exit, when coolc has freed the tree: only the class nodes are read. */
+static void semant_stats_report()
+{
+	FILE *out = strcmp( stats_file, "-") ? fopen( stats_file, "w") : stderr;
+	if ( !out)
+	{
+		cerr << "Cannot open " << stats_file << " for COOL_SEMANT_STATS" << endl;
+		return;
+	}
+
+	fprintf( out, "{\n  \"classes\": [");
+	const std::vector< class_tree_node> &preorder = class_tree_node_type::preorder;
+	const char *sep = "\n";
+	for ( size_t i = 0; i < preorder.size() && i < check_secs.size(); ++i)
+	{
+		class_tree_node c = preorder[i];
+		if ( !c->is_defined())
 		{
-			semant_error( cur) << "It's illegal to inherit from SELF_TYPE " << endl;
-			father_node = Object_type;
+			continue;
 		}
+		fprintf( out, "%s    {\"name\": ", sep);
+		json_string( out, c->name->get_string());
+		fprintf( out, ", \"depth\": %d, \"install_seconds\": %.6f, \"check_seconds\": %.6f}",
+				c->depth, install_secs[i], check_secs[i]);
+		sep = ",\n";
+	}
+	fprintf( out, "%s],\n", *sep == ',' ? "\n  " : "");
+#ifdef SEMANT_STATS
+	static const symtable_type::calls_type none = symtable_type::calls_type();
+	const semant_stats_type &t = semant_stats;
+	json_calls( out, "var_table", var_table ? var_table->calls : none);
+	json_calls( out, "class_table", class_table ? class_table->calls : none);
+	fprintf( out, "  \"find_method\": {\"calls\": %ld, \"cached\": %ld, "
+			"\"homonym_scans\": %ld, \"homonyms_scanned\": %ld, "
+			"\"chain_walks\": %ld, \"chain_steps\": %ld, \"longest_chain\": %ld},\n",
+			t.method_finds, t.method_cached, t.homonym_scans, t.homonyms_scanned,
+			t.chain_walks, t.chain_steps, t.longest_chain);
+	fprintf( out, "  \"is_sub_class_of\": {\"calls\": %ld},\n", t.sub_class_tests);
+	fprintf( out, "  \"find_class_lca\": {\"calls\": %ld},\n", t.lca_queries);
+	fprintf( out, "  \"get_Expr_Type\": {\"checked\": %ld, \"memo_hits\": %ld}\n}\n",
+			t.expr_checks, t.expr_memo_hits);
+#else
+	fprintf( out, "  \"counts\": \"need a build with -DSEMANT_STATS\"\n}\n");
+#endif
+
+	if ( out != stderr)
+	{
+		fclose( out);
+	}
+}
+
+static void stats_start()
+{
+	static bool started;
+	if ( started)
+	{
+		return;
+	}
+	started = true;
+	char *file = getenv( "COOL_SEMANT_STATS");
+	if ( file && *file)
+	{
+		stats_file = file;
+		atexit( semant_stats_report);
+	}
+}
 
-		if ( !ct_node->set_father( father_node))
+ClassTable::ClassTable(Classes classes) : semant_errors(0) , error_stream(&cerr) , held(NULL) , closed(false) {
+	begin();
+	for ( int i = classes->first(); classes->more( i); i = classes->next( i))
+	{
+		if ( !add_class( classes->nth( i)))
 		{
-			// Find error: cur could not be a subclass of father node.
-			semant_error( cur) << "Find inherit circle of Class " << cur->get_name()
-				<< " and Class " << cur->get_parent_name() << endl;
-			return;
+			break;
 		}
-		++cnt;
 	}
+	finish();
+}
+
+ClassTable::ClassTable() : semant_errors(0) , error_stream(NULL) , held(new std::ostringstream) , closed(false) {
+	error_stream = held;
+	begin();
+}
+
+void ClassTable::begin()
+{
+	stats_start();
+	cls_table = this;
+	class_table = &symtable;
+	var_table = &vartable;
+
+	class_table->enterscope();
+	methods_by_name.clear();
+
+	install_basic_classes();
+	if ( !class_table->probe( Object))
+	{
+		// Find bug: No root !
+		semant_error() << "BUG: Could not find object class." << endl;
+		closed = true;
+	}
+}
+
+/*
+ * Installs one class in the inheritance graph.  Returns false, and
+ * takes no more classes, once the graph can't be completed.
+ */
+bool ClassTable::add_class(Class_ cur)
+{
+	if ( closed)
+	{
+		return false;
+	}
+
+	class_tree_node ct_node = lookup_install_type( cur->get_name());
+
+	if ( ct_node->contain == NULL)
+	{
+		ct_node->set_contain( cur);
+	}
+	else
+	{
+		// Find error: Redefinition of class
+		semant_error( cur) << "Redefinition of Class " << cur->get_name() << endl;
+		closed = true;
+		return false;
+	}
+
+	class_tree_node father_node = lookup_install_type( cur->get_parent_name());
+	if ( father_node == ct_node)
+	{
+		semant_error( cur) << "Class " << cur->get_name() <<
+			" count not be the super class of itself." << endl;
+	}
+
+	if ( father_node == Bool_type || father_node == Int_type || father_node == Str_type)
+	{
+		semant_error( cur) << "It's illegal to inherit from Class " <<
+			cur->get_parent_name() << endl;
+	}
+
+	if ( father_node == Self_type)
+	{
+		semant_error( cur) << "It's illegal to inherit from SELF_TYPE " << endl;
+		father_node = Object_type;
+	}
+
+	if ( !ct_node->set_father( father_node))
+	{
+		// Find error: cur could not be a subclass of father node.
+		semant_error( cur) << "Find inherit circle of Class " << cur->get_name()
+			<< " and Class " << cur->get_parent_name() << endl;
+		closed = true;
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Checks the program once every class is in.  A streaming table prints
+ * what it held back first, and reports straight to cerr from then on.
+ */
+void ClassTable::finish()
+{
+	if ( held)
+	{
+		cerr << held->str();
+		delete held;
+		held = NULL;
+		error_stream = &cerr;
+	}
+
+	if ( closed)
+	{
+		return;
+	}
+	closed = true;
 
 	class_tree_node_type::fill_node_depth();
 
-	root->walk_down();
+	if ( stats_file)
+	{
+		install_secs.assign( class_tree_node_type::preorder.size(), 0.0);
+		check_secs.assign( class_tree_node_type::preorder.size(), 0.0);
+	}
+
+	class_table->probe( Object)->walk_down();
 
 	if ( !class_table->lookup( Main))
 	{
@@ -454,14 +694,14 @@ ostream& ClassTable::semant_error(Class_ c)
 
 ostream& ClassTable::semant_error(Symbol filename, tree_node *t)
 {
-    error_stream << filename << ":" << t->get_line_number() << ": ";
+    *error_stream << filename << ":" << t->get_line_number() << ": ";
     return semant_error();
 }
 
 ostream& ClassTable::semant_error()
 {
     semant_errors++;
-    return error_stream;
+    return *error_stream;
 }
 
 
@@ -487,35 +727,128 @@ ostream& semant_error()
 }
 
 class_tree_node class_tree_node_type::all_node_head = NULL;
+std::vector< class_tree_node> class_tree_node_type::preorder;
+std::vector< class_tree_node> class_tree_node_type::tour;
+std::vector< class_tree_node> class_tree_node_type::lca_table;
+std::vector< int> class_tree_node_type::lca_log;
+
+/*
+ * Numbers every class in preorder and lays out the Euler tour, one
+ * root at a time, with a stack of each open class and the son to visit
+ * next; then fills the sparse table a row at a time.
+ */
+void class_tree_node_type::number_nodes()
+{
+	preorder.clear();
+	tour.clear();
+	int count = 0;
+	std::vector< std::pair< class_tree_node, class_tree_node> > open;
+	for ( class_tree_node root = all_node_head; root; root = root->all_node_next)
+	{
+		if ( root->father || root->depth < 0)
+		{
+			continue;
+		}
+		root->enter = count++;
+		preorder.push_back( root);
+		root->tour_at = tour.size();
+		tour.push_back( root);
+		open.push_back( std::make_pair( root, root->son));
+		while ( !open.empty())
+		{
+			class_tree_node son = open.back().second;
+			if ( son)
+			{
+				open.back().second = son->sibling;
+				son->enter = count++;
+				preorder.push_back( son);
+				son->tour_at = tour.size();
+				tour.push_back( son);
+				open.push_back( std::make_pair( son, son->son));
+			}
+			else
+			{
+				open.back().first->leave = count - 1;
+				open.pop_back();
+				if ( !open.empty())
+				{
+					tour.push_back( open.back().first);
+				}
+			}
+		}
+	}
+
+	size_t n = tour.size();
+	lca_log.assign( n + 1, 0);
+	for ( size_t i = 2; i <= n; ++i)
+	{
+		lca_log[i] = lca_log[i / 2] + 1;
+	}
+	lca_table.assign( tour.begin(), tour.end());
+	for ( size_t k = 1; ( ( size_t) 1 << k) <= n; ++k)
+	{
+		size_t half = ( size_t) 1 << ( k - 1);
+		size_t last = ( k - 1) * n;
+		lca_table.resize( ( k + 1) * n);
+		for ( size_t i = 0; i + 2 * half <= n; ++i)
+		{
+			class_tree_node a = lca_table[last + i];
+			class_tree_node b = lca_table[last + i + half];
+			lca_table[k * n + i] = a->depth <= b->depth ? a : b;
+		}
+	}
+}
+
 bool class_tree_node_type::is_defined() const
 {
 	return contain && this != Null_type;
 }
 
+/*
+ * Climbs from this class to the first one with a depth, or to a root,
+ * then sets the depths on the way back down.  A class whose father is
+ * undefined is reported as it is reached, nearest the root first.
+ */
 bool class_tree_node_type::fill_depth()
 {
-	if ( depth == -1)
+	if ( depth != -1)
 	{
-		if ( father)
-		{
-			if ( !father->fill_depth())
-			{
-				semant_error( this->contain)
-					<< "Class " << name << " inherited from undefined Class "
-					<< father->name << "." << endl;
-			}
-			depth = father->depth + 1;
-		}
-		else
+		return this->contain;
+	}
+
+	std::vector< class_tree_node> path;
+	class_tree_node top = this;
+	while ( top->depth == -1 && top->father)
+	{
+		path.push_back( top);
+		top = top->father;
+	}
+	if ( top->depth == -1)
+	{
+		top->depth = 0;
+		top->find_set();
+	}
+
+	for ( size_t i = path.size(); i-- > 0; )
+	{
+		class_tree_node leg = path[i];
+		if ( !leg->father->contain)
 		{
-			depth = 0;
+			semant_error( leg->contain)
+				<< "Class " << leg->name << " inherited from undefined Class "
+				<< leg->father->name << "." << endl;
 		}
-		find_set();
+		leg->depth = leg->father->depth + 1;
+		leg->find_set();
 	}
 	return this->contain;
 }
 
-bool class_tree_node_type::walk_down()
+/*
+ * Installs and checks this class's features in the scope its fathers'
+ * attributes make.
+ */
+void class_tree_node_type::check_in_scope()
 {
 	::Current_type = this;
 	::filename = contain->get_filename();
@@ -536,24 +869,51 @@ bool class_tree_node_type::walk_down()
 
 	if ( is_defined())
 	{
+		double start = stats_file ? stats_now() : 0;
+		this->contain->install_Class_Types();
+		if ( stats_file)
+		{
+			start = stats_lap( install_secs, this, start);
+		}
 		this->contain->check_Class_Types();
+		if ( stats_file)
+		{
+			stats_lap( check_secs, this, start);
+		}
 	}
 	else
 	{
 		// Find an undefined class.
 		// Will be reported later.
 	}
+}
 
-	bool ret = true;
-	class_tree_node leg = this->son;
-	while ( leg)
+/*
+ * Checks this class and its subclasses in preorder, with a stack of
+ * each open class and the son to visit next; a class's scope is left
+ * once its last son is done.
+ */
+bool class_tree_node_type::walk_down()
+{
+	std::vector< std::pair< class_tree_node, class_tree_node> > open;
+	check_in_scope();
+	open.push_back( std::make_pair( this, this->son));
+	while ( !open.empty())
 	{
-		ret &= leg->walk_down();
-		leg = leg->sibling;
+		class_tree_node son = open.back().second;
+		if ( son)
+		{
+			open.back().second = son->sibling;
+			son->check_in_scope();
+			open.push_back( std::make_pair( son, son->son));
+		}
+		else
+		{
+			var_table->exitscope();
+			open.pop_back();
+		}
 	}
-
-	var_table->exitscope();
-	return ret;
+	return true;
 }
 
 /*   This is the entry point to the semantic checker.
@@ -569,12 +929,37 @@ bool class_tree_node_type::walk_down()
      errors. Part 2) can be done in a second stage, when you want
      to build mycoolc.
  */
-void program_class::semant()
+/*
+ * Streaming, for a driver that parses and checks in one process:
+ * semant_stream_begin() before the parse, then semant_stream_class()
+ * for each class as the parser finishes it.  program_class::semant()
+ * completes the table built that way instead of starting a new one.
+ */
+static ClassTable *streamed_table;
+
+void semant_stream_begin()
 {
     initialize_constants();
+    streamed_table = new ClassTable();
+}
 
-    /* ClassTable constructor may do some semantic analysis */
-    ClassTable *classtable = new ClassTable(classes);
+void semant_stream_class(Class_ c)
+{
+    streamed_table->add_class(c);
+}
+
+void program_class::semant()
+{
+    ClassTable *classtable;
+    if (streamed_table) {
+	classtable = streamed_table;
+	classtable->finish();
+    } else {
+	initialize_constants();
+
+	/* ClassTable constructor may do some semantic analysis */
+	classtable = new ClassTable(classes);
+    }
 
     /* some semantic analysis code may go here */
 
@@ -584,24 +969,136 @@ void program_class::semant()
     }
 }
 
+/*
+ * Checks the expression with a stack of its own rather than the C
+ * stack, so that nesting is only limited by memory: each node's check
+ * is split into steps by check_Expr_Step() (see check_frame_type), and
+ * the subexpression a step asks for is pushed and checked in turn.
+ */
 Type Expression_class::get_Expr_Type()
 {
-	if ( !checked)
+	if ( checked)
 	{
-		expr_type = do_Check_Expr_Type();
-		if ( expr_type)
+		semant_count( semant_stats.expr_memo_hits);
+		return expr_type;
+	}
+
+	std::vector< check_frame_type> stack;
+	stack.push_back( check_frame_type( this));
+	while ( !stack.empty())
+	{
+		check_frame_type &f = stack.back();
+		Expression next = f.expr->check_Expr_Step( f);
+		if ( next)
 		{
-			set_type( expr_type->name);
+			if ( next->checked)
+			{
+				semant_count( semant_stats.expr_memo_hits);
+				f.sub = next->expr_type;
+			}
+			else
+			{
+				stack.push_back( check_frame_type( next));
+			}
+			continue;
+		}
+
+		Expression done = f.expr;
+		done->expr_type = f.ret;
+		if ( done->expr_type)
+		{
+			done->set_type( done->expr_type->name);
 		}
 		else
 		{
-			set_type( NULL);
+			done->set_type( NULL);
+		}
+		done->checked = true;
+		semant_count( semant_stats.expr_checks);
+
+		stack.pop_back();
+		if ( !stack.empty())
+		{
+			stack.back().sub = done->expr_type;
 		}
-		checked = true;
 	}
 	return expr_type;
 }
 
+void class_tree_node_type::add_method( Symbol name, class_method method)
+{
+	method_table.addid( name, method);
+	method->owner = this;
+	method->homonym = methods_by_name.lookup( name);
+	method->homonyms = method->homonym ? method->homonym->homonyms + 1 : 1;
+	methods_by_name.add( name, method);
+}
+
+/*
+ * The method a class has of a name is the one defined in its deepest
+ * ancestor, itself included, that defines the name at all.  That is
+ * found either among the methods of the name, by their owners'
+ * preorder numbers, or by searching up the father chain, whichever
+ * has fewer places to look; then it is kept in the class's method
+ * cache.
+ */
+class_method class_tree_node_type::find_method( Symbol name)
+{
+	semant_count( semant_stats.method_finds);
+	class_method ret = methods.lookup( name);
+	if ( ret)
+	{
+		semant_count( semant_stats.method_cached);
+		return ret;
+	}
+
+	class_method last = methods_by_name.lookup( name);
+	if ( !last)
+	{
+		return NULL;
+	}
+
+	if ( enter >= 0 && last->homonyms <= depth)
+	{
+		semant_count( semant_stats.homonym_scans);
+		semant_count( semant_stats.homonyms_scanned, last->homonyms);
+		for ( class_method m = last; m; m = m->homonym)
+		{
+			class_tree_node owner = m->owner;
+			if ( owner->enter <= enter && enter <= owner->leave
+					&& ( !ret || owner->depth > ret->owner->depth))
+			{
+				ret = m;
+			}
+		}
+	}
+	else
+	{
+		long steps = 0;
+		for ( class_tree_node leg = this; leg && !ret; leg = leg->father, ++steps)
+		{
+			if ( !( ret = leg->methods.lookup( name)))
+			{
+				ret = leg->method_table.lookup( name);
+			}
+		}
+		semant_count( semant_stats.chain_walks);
+		semant_count( semant_stats.chain_steps, steps);
+#ifdef SEMANT_STATS
+		if ( steps > semant_stats.longest_chain)
+		{
+			semant_stats.longest_chain = steps;
+		}
+#endif
+	}
+
+	if ( ret)
+	{
+		methods.add( name, ret);
+	}
+	return ret;
+}
+
 void class__class::collect_Methods()
 {
 	for ( int i = features->first(); features->more( i); i = features->next( i))
@@ -610,14 +1107,17 @@ void class__class::collect_Methods()
 	}
 }
 
-bool class__class::check_Class_Types()
+void class__class::install_Class_Types()
 {
 	for ( int i = features->first(); features->more( i); i = features->next( i))
 	{
 		Feature ft = features->nth( i);
 		ft->install_Feature_Types();
 	}
+}
 
+bool class__class::check_Class_Types()
+{
 	/*
 	cout << "Var table: " << endl;
 	var_table->dump();
@@ -644,18 +1144,15 @@ void method_class::collect_Feature_Types()
 {
 	feature_type = lookup_install_type( return_type);
 
-	class_method syms = new class_method_type( feature_type);
-	class_method last = syms;
+	class_method syms = new class_method_type( formals->len());
+	syms->set_return_type( feature_type);
+	int n = 0;
 	for ( int i = formals->first(); formals->more( i); i = formals->next( i))
 	{
-		Type type = formals->nth( i)->collect_Formal_Type();
-		class_method cur = new class_method_type( type);
-
-		last->set_tl( cur);
-		last = cur;
+		syms->set_formal( n++, formals->nth( i)->collect_Formal_Type());
 	}
 
-	method_table->addid( name, syms);
+	collecting_class->add_method( name, syms);
 }
 
 bool method_class::install_Feature_Types()
@@ -839,43 +1336,51 @@ bool branch_class::install_Case_Type()
 	return true;
 }
 
-Type branch_class::check_Case_Type( Type path_type)
+/*
+ * The case's scope for this branch.  Returns the branch's expression
+ * to check inside it, or NULL, with no scope entered, if the branch's
+ * class is not defined.
+ */
+Expression branch_class::enter_Case_Scope()
 {
-	Type ret = Null_type;
-
 	if ( !id_type)
 	{
 		semant_error( filename, this) << "Class " << type_decl <<
 			" is not defined." << endl;
+		return NULL;
 	}
-	else
-	{
-		var_table->enterscope();
-		var_table->addid( name, id_type);
-
-		ret = expr->get_Expr_Type();
 
-		var_table->exitscope();
-	}
+	var_table->enterscope();
+	var_table->addid( name, id_type);
+	return expr;
+}
 
-	return ret ? ret : path_type;
+void branch_class::exit_Case_Scope()
+{
+	var_table->exitscope();
 }
 
-Type assign_class::do_Check_Expr_Type()
+Expression assign_class::check_Expr_Step( check_frame_type &f)
 {
-	/*
-	cout << "Variable table:";
-	var_table->dump();
-	cout << endl;
-	*/
-	if ( name == self)
+	if ( f.step++ == 0)
 	{
-		semant_error( filename, this)
-			<< "Assignment on self object." << endl;
+		/*
+		cout << "Variable table:";
+		var_table->dump();
+		cout << endl;
+		*/
+		if ( name == self)
+		{
+			semant_error( filename, this)
+				<< "Assignment on self object." << endl;
+		}
+
+		f.a = var_table->lookup( name);
+		return expr;
 	}
 
-	Type n1 = var_table->lookup( name);
-	Type n2 = expr->get_Expr_Type();
+	Type n1 = f.a;
+	Type n2 = f.sub;
 	if ( !n1)
 	{
 		semant_error( filename, this) << "Variable " << name <<
@@ -891,56 +1396,73 @@ Type assign_class::do_Check_Expr_Type()
 		}
 	}
 
-	return n2;
+	f.ret = n2;
+	return NULL;
 }
 
-Type check_dispatch( Type caller, Type real_caller, Symbol name, Expressions actual, Expression e)
+/*
+ * Checks the actuals of a dispatch against the method's formals, from
+ * f.step 2 on: f.a is the type of the object dispatched to, f.b the
+ * class whose method is called.
+ */
+Expression check_dispatch( check_frame_type &f, Symbol name, Expressions actual, Expression e)
 {
-	class_method types = real_caller->find_method( name);
-	if ( !types)
+	if ( f.step == 2)
 	{
-		semant_error( filename, e)
-			<< "Calls on method " << name << " on Class "
-			<< real_caller->name << " failed." << endl;
-		semant_error( filename, e)
-			<< "\t" << "Could not find method." << endl;
-		return Null_type;
-	}
-
-	Type ret_type = types->hd();
-	ret_type = ret_type == Self_type ? caller : ret_type;
+		class_method types = f.b->find_method( name);
+		if ( !types)
+		{
+			semant_error( filename, e)
+				<< "Calls on method " << name << " on Class "
+				<< f.b->name << " failed." << endl;
+			semant_error( filename, e)
+				<< "\t" << "Could not find method." << endl;
+			f.ret = Null_type;
+			return NULL;
+		}
 
-	types = types->tl();
+		Type ret_type = types->return_type();
+		f.ret = ret_type == Self_type ? f.a : ret_type;
 
-	int i = actual->first();
-	while ( actual->more( i) && types)
+		f.types = types;
+		f.formal = 0;
+		f.i = actual->first();
+		f.step = 3;
+	}
+	else
 	{
-		Expression expr = actual->nth( i);
-		Type act_type = expr->get_Expr_Type();
-		Type para_type = types->hd();
+		Type act_type = f.sub;
+		Type para_type = f.types->formal( f.formal);
 
 		act_type = act_type == Self_type ? Current_type : act_type;
 
 		if ( act_type && para_type &&
 				act_type.is_sub_type_of( para_type))
 		{
-			types = types->tl(), i = actual->next( i);
+			++f.formal, f.i = actual->next( f.i);
 		}
 		else
 		{
-			break;
+			f.step = 4;
 		}
 	}
-	if ( actual->more( i) || types)
+
+	bool formals_left = f.formal < f.types->formal_count();
+	if ( f.step == 3 && actual->more( f.i) && formals_left)
+	{
+		return actual->nth( f.i);
+	}
+
+	if ( actual->more( f.i) || formals_left)
 	{
 		char *err_str;
-		if ( !actual->more( i))
+		if ( !actual->more( f.i))
 		{
 			err_str = "Too few arguments supplied.";
 		}
 		else
 		{
-			if ( types)
+			if ( formals_left)
 			{
 				err_str = "Arguments miss match.";
 			}
@@ -952,17 +1474,27 @@ Type check_dispatch( Type caller, Type real_caller, Symbol name, Expressions act
 
 		semant_error( filename, e)
 			<< "Calls on method " << name << " on Class "
-			<< real_caller->name << " failed." << endl;
+			<< f.b->name << " failed." << endl;
 		semant_error( filename, e)
 			<< "\t" << err_str << endl;
 	}
 
-	return ret_type;
+	return NULL;
 }
 
-Type static_dispatch_class::do_Check_Expr_Type()
+Expression static_dispatch_class::check_Expr_Step( check_frame_type &f)
 {
-	Type caller = expr->get_Expr_Type();
+	if ( f.step == 0)
+	{
+		f.step = 1;
+		return expr;
+	}
+	if ( f.step > 1)
+	{
+		return check_dispatch( f, name, actual, this);
+	}
+
+	Type caller = f.sub;
 	Type real_caller = class_table->lookup( type_name);
 	if ( !real_caller || !caller || !caller.is_sub_type_of( real_caller))
 	{
@@ -982,122 +1514,234 @@ Type static_dispatch_class::do_Check_Expr_Type()
 					<< " to Class " << type_name << endl;
 			}
 		}
-		return Null_type;
+		f.ret = Null_type;
+		return NULL;
 	}
 
-	return check_dispatch( caller, real_caller, name, actual, this);
+	f.a = caller;
+	f.b = real_caller;
+	f.step = 2;
+	return check_dispatch( f, name, actual, this);
 }
 
-Type dispatch_class::do_Check_Expr_Type()
+Expression dispatch_class::check_Expr_Step( check_frame_type &f)
 {
-	Type caller = expr->get_Expr_Type();
+	if ( f.step == 0)
+	{
+		f.step = 1;
+		return expr;
+	}
+	if ( f.step > 1)
+	{
+		return check_dispatch( f, name, actual, this);
+	}
+
+	Type caller = f.sub;
 	if ( !caller)
 	{
 		// What's the fuck with caller.
-		return Null_type;
+		f.ret = Null_type;
+		return NULL;
 	}
 
-	Type real_caller = caller == Self_type ? Current_type : caller;
-
-	return check_dispatch( caller, real_caller, name, actual, this);
+	f.a = caller;
+	f.b = caller == Self_type ? Current_type : caller;
+	f.step = 2;
+	return check_dispatch( f, name, actual, this);
 }
 
-Type cond_class::do_Check_Expr_Type()
+Expression cond_class::check_Expr_Step( check_frame_type &f)
 {
-	Type then_type = then_exp->get_Expr_Type();
-	Type else_type = else_exp->get_Expr_Type();
-	return pred->get_Expr_Type() == Bool_type &&
+	switch ( f.step++)
+	{
+	case 0:
+		return then_exp;
+	case 1:
+		f.a = f.sub;
+		return else_exp;
+	case 2:
+		f.b = f.sub;
+		return pred;
+	}
+
+	Type then_type = f.a;
+	Type else_type = f.b;
+	f.ret = f.sub == Bool_type &&
 		then_type && else_type
 		? find_type_lca( then_type, else_type) : Null_type;
+	return NULL;
 }
 
-Type loop_class::do_Check_Expr_Type()
+Expression loop_class::check_Expr_Step( check_frame_type &f)
 {
-	if ( pred->get_Expr_Type() != Bool_type)
+	switch ( f.step++)
 	{
-		semant_error( filename, this) << "Condition exprssions should be Bool." << endl;
+	case 0:
+		return pred;
+	case 1:
+		if ( f.sub != Bool_type)
+		{
+			semant_error( filename, this) << "Condition exprssions should be Bool." << endl;
+		}
+		return body;
 	}
-	body->get_Expr_Type();
 
 	// Errors should be handled in body;
-	return Object_type;
+	f.ret = Object_type;
+	return NULL;
 }
 
-Type typcase_class::do_Check_Expr_Type()
+/*
+ * f.a is the type of the expression cased on, f.b the type of the case
+ * so far, and f.i the branch being checked.
+ */
+Expression typcase_class::check_Expr_Step( check_frame_type &f)
 {
-	Type path_type = expr->get_Expr_Type();
-	Type value_type = Null_type;
-	if ( path_type)
+	if ( f.step == 0)
 	{
-		class_table->enterscope();
-		for ( int i = cases->first(); cases->more( i); i = cases->next( i))
-		{
-			Case br = cases->nth( i);
+		f.step = 1;
+		return expr;
+	}
 
-			br->install_Case_Type();
-			Type br_type = br->check_Case_Type( path_type);
+	if ( f.step == 1)
+	{
+		f.a = f.sub;
+		f.b = Null_type;
+		if ( !f.a)
+		{
+			f.ret = f.b;
+			return NULL;
+		}
+		class_table->enterscope();
+		f.i = cases->first();
+		f.step = 2;
+	}
+	else
+	{
+		Case br = cases->nth( f.i);
+		br->exit_Case_Scope();
+		Type br_type = f.sub ? f.sub : f.a;
+		f.i = cases->next( f.i);
 
-			if ( !br_type)
+		if ( !br_type)
+		{
+			f.b = Null_type;
+		}
+		else
+		{
+			if ( f.b)
 			{
-				value_type = Null_type;
+				f.b = find_type_lca( f.b, br_type);
 			}
 			else
 			{
-				if ( value_type)
-				{
-					value_type = find_type_lca( value_type, br_type);
-				}
-				else
-				{
-					value_type = br_type;
-				}
+				f.b = br_type;
 			}
+		}
 
-			if ( !value_type)
-			{
-				break;
-			}
+		if ( !f.b)
+		{
+			class_table->exitscope();
+			f.ret = f.b;
+			return NULL;
 		}
-		class_table->exitscope();
 	}
 
-	return value_type;
-}
-
-Type block_class::do_Check_Expr_Type()
-{
-	Type ret = Object_type;
-	for ( int i = body->first(); body->more( i) && ret; i = body->next( i))
+	// An undefined branch class gives the branch the type cased on.
+	for ( ; cases->more( f.i); f.i = cases->next( f.i))
 	{
-		ret = body->nth(i)->get_Expr_Type();
+		Case br = cases->nth( f.i);
+
+		br->install_Case_Type();
+		Expression br_expr = br->enter_Case_Scope();
+		if ( br_expr)
+		{
+			return br_expr;
+		}
+
+		if ( f.b)
+		{
+			f.b = find_type_lca( f.b, f.a);
+		}
+		else
+		{
+			f.b = f.a;
+		}
+
+		if ( !f.b)
+		{
+			break;
+		}
 	}
-	return ret;
+	class_table->exitscope();
+
+	f.ret = f.b;
+	return NULL;
 }
 
-Type let_class::do_Check_Expr_Type()
+Expression block_class::check_Expr_Step( check_frame_type &f)
 {
-	if ( identifier == self)
+	if ( f.step++ == 0)
 	{
-		semant_error( filename, this)
-			<< "Binding self as an identifier." << endl;
+		f.ret = Object_type;
+		f.i = body->first();
 	}
+	else
+	{
+		f.ret = f.sub;
+		f.i = body->next( f.i);
+	}
+	return body->more( f.i) && f.ret ? body->nth( f.i) : NULL;
+}
 
-	Type id_type = class_table->lookup( type_decl);
-	Type expr_type = init->is_no_expr() ? id_type : init->get_Expr_Type();
-
-	Type ret = Null_type;
-	if ( id_type && expr_type && expr_type.is_sub_type_of( id_type))
+/*
+ * f.a is the declared type, f.b the type of the initialization.
+ */
+Expression let_class::check_Expr_Step( check_frame_type &f)
+{
+	switch ( f.step)
 	{
-		var_table->enterscope();
-		var_table->addid( identifier, id_type);
+	case 0:
+		if ( identifier == self)
+		{
+			semant_error( filename, this)
+				<< "Binding self as an identifier." << endl;
+		}
 
-		Type body_type = body->get_Expr_Type();
-		if ( body_type)
+		f.a = class_table->lookup( type_decl);
+		if ( !init->is_no_expr())
+		{
+			f.step = 1;
+			return init;
+		}
+		f.b = f.a;
+		break;
+	case 1:
+		f.b = f.sub;
+		break;
+	case 2:
+		if ( f.sub)
 		{
-			ret = body_type;
+			f.ret = f.sub;
 		}
 
 		var_table->exitscope();
+		break;
+	}
+
+	Type id_type = f.a;
+	Type expr_type = f.b;
+	if ( f.step < 2)
+	{
+		f.ret = Null_type;
+		if ( id_type && expr_type && expr_type.is_sub_type_of( id_type))
+		{
+			var_table->enterscope();
+			var_table->addid( identifier, id_type);
+
+			f.step = 2;
+			return body;
+		}
 	}
 
 	if ( !id_type)
@@ -1114,65 +1758,93 @@ Type let_class::do_Check_Expr_Type()
 			<< expr_type->name << endl;
 	}
 
-	return ret;
+	return NULL;
 }
 
-Type check_Arith( Expression e1, Expression e2, char *name, Expression e)
+Expression check_Arith( check_frame_type &f, Expression e1, Expression e2, const char *name, Expression e)
 {
-	if ( e1->get_Expr_Type() != Int_type)
+	switch ( f.step++)
 	{
-		semant_error( filename, e) << "Left operhand of operator "
-			<< name << " should be Int." << endl;
+	case 0:
+		return e1;
+	case 1:
+		if ( f.sub != Int_type)
+		{
+			semant_error( filename, e) << "Left operhand of operator "
+				<< name << " should be Int." << endl;
+		}
+		return e2;
 	}
-	if ( e2->get_Expr_Type() != Int_type)
+
+	if ( f.sub != Int_type)
 	{
 		semant_error( filename, e) << "Right operhand of oprator"
 			<< name << " should be Int." << endl;
 	}
 
-	return Int_type;
+	f.ret = Int_type;
+	return NULL;
 }
 
-Type plus_class::do_Check_Expr_Type()
+Expression plus_class::check_Expr_Step( check_frame_type &f)
 {
-	return check_Arith(e1, e2, "'+'", this);
+	return check_Arith( f, e1, e2, "'+'", this);
 }
 
-Type sub_class::do_Check_Expr_Type()
+Expression sub_class::check_Expr_Step( check_frame_type &f)
 {
-	return check_Arith(e1, e2, "'-'", this);
+	return check_Arith( f, e1, e2, "'-'", this);
 }
 
-Type mul_class::do_Check_Expr_Type()
+Expression mul_class::check_Expr_Step( check_frame_type &f)
 {
-	return check_Arith(e1, e2, "'*'", this);
+	return check_Arith( f, e1, e2, "'*'", this);
 }
 
-Type divide_class::do_Check_Expr_Type()
+Expression divide_class::check_Expr_Step( check_frame_type &f)
 {
-	return check_Arith(e1, e2, "'/'", this);
+	return check_Arith( f, e1, e2, "'/'", this);
 }
 
-Type neg_class::do_Check_Expr_Type()
+Expression neg_class::check_Expr_Step( check_frame_type &f)
 {
-	if ( e1->get_Expr_Type() != Int_type)
+	if ( f.step++ == 0)
+	{
+		return e1;
+	}
+
+	if ( f.sub != Int_type)
 	{
 		semant_error( filename, this) << "Operhand of operator "
 			<< "'-' should be Int." << endl;
 	}
-	return Int_type;
+	f.ret = Int_type;
+	return NULL;
 }
 
-Type lt_class::do_Check_Expr_Type()
+Expression lt_class::check_Expr_Step( check_frame_type &f)
 {
-	check_Arith( e1, e2, "'<'", this);
-	return Bool_type;
+	Expression next = check_Arith( f, e1, e2, "'<'", this);
+	if ( !next)
+	{
+		f.ret = Bool_type;
+	}
+	return next;
 }
 
-Type eq_class::do_Check_Expr_Type()
+Expression eq_class::check_Expr_Step( check_frame_type &f)
 {
-	Type type1 = e1->get_Expr_Type();
-	Type type2 = e2->get_Expr_Type();
+	switch ( f.step++)
+	{
+	case 0:
+		return e1;
+	case 1:
+		f.a = f.sub;
+		return e2;
+	}
+
+	Type type1 = f.a;
+	Type type2 = f.sub;
 
 	if ( ( type1 != type2) &&
 			( type1 == Int_type || type2 == Int_type ||
@@ -1184,41 +1856,55 @@ Type eq_class::do_Check_Expr_Type()
 			<< endl;
 	}
 
-	return Bool_type;
+	f.ret = Bool_type;
+	return NULL;
 }
 
-Type leq_class::do_Check_Expr_Type()
+Expression leq_class::check_Expr_Step( check_frame_type &f)
 {
-	check_Arith( e1, e2, "'<='", this);
-	return Bool_type;
+	Expression next = check_Arith( f, e1, e2, "'<='", this);
+	if ( !next)
+	{
+		f.ret = Bool_type;
+	}
+	return next;
 }
 
-Type comp_class::do_Check_Expr_Type()
+Expression comp_class::check_Expr_Step( check_frame_type &f)
 {
-	if ( e1->get_Expr_Type() != Bool_type)
+	if ( f.step++ == 0)
+	{
+		return e1;
+	}
+
+	if ( f.sub != Bool_type)
 	{
 		semant_error( filename, this) << "Operator '!' could only used on bool expression." << endl;
 	}
 
-	return Bool_type;
+	f.ret = Bool_type;
+	return NULL;
 }
 
-Type int_const_class::do_Check_Expr_Type()
+Expression int_const_class::check_Expr_Step( check_frame_type &f)
 {
-	return Int_type;
+	f.ret = Int_type;
+	return NULL;
 }
 
-Type bool_const_class::do_Check_Expr_Type()
+Expression bool_const_class::check_Expr_Step( check_frame_type &f)
 {
-	return Bool_type;
+	f.ret = Bool_type;
+	return NULL;
 }
 
-Type string_const_class::do_Check_Expr_Type()
+Expression string_const_class::check_Expr_Step( check_frame_type &f)
 {
-	return Str_type;
+	f.ret = Str_type;
+	return NULL;
 }
 
-Type new__class::do_Check_Expr_Type()
+Expression new__class::check_Expr_Step( check_frame_type &f)
 {
 	Type type = class_table->lookup( type_name);
 
@@ -1227,29 +1913,36 @@ Type new__class::do_Check_Expr_Type()
 		semant_error( filename, this) << "Class " << type_name << " not defined." << endl;
 	}
 
-	return type;
+	f.ret = type;
+	return NULL;
 }
 
-Type isvoid_class::do_Check_Expr_Type()
+Expression isvoid_class::check_Expr_Step( check_frame_type &f)
 {
 	// Error must be resolved in e1.
 	// Assuming it's always right.
-	e1->get_Expr_Type();
-	return Bool_type;
+	if ( f.step++ == 0)
+	{
+		return e1;
+	}
+	f.ret = Bool_type;
+	return NULL;
 }
 
-Type no_expr_class::do_Check_Expr_Type()
+Expression no_expr_class::check_Expr_Step( check_frame_type &f)
 {
 	// This would only be called when checking object method.
-	return Null_type;
+	f.ret = Null_type;
+	return NULL;
 }
 
-Type object_class::do_Check_Expr_Type()
+Expression object_class::check_Expr_Step( check_frame_type &f)
 {
 	Type ret = var_table->lookup( name);
 	if ( !ret)
 	{
 		semant_error( filename, this) << "Variable " << name << " not defined." << endl;
 	}
-	return ret;
+	f.ret = ret;
+	return NULL;
 }
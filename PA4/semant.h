@@ -3,12 +3,14 @@
 
 #include <assert.h>
 #include <iostream>
+#include <sstream>
 #include "cool-tree.h"
 #include "stringtab.h"
-#include "symtab.h"
+#include "scoped-table.h"
 #include "list.h"
 
 #include <utility>
+#include <vector>
 
 #define TRUE 1
 #define FALSE 0
@@ -27,29 +29,115 @@ typedef class_tree_node_type *class_tree_node;
 struct class_method_type;
 typedef class_method_type *class_method;
 
-typedef SymbolTable< Symbol, class_tree_node_type> symtable_type;
-typedef SymbolTable< Symbol, class_method_type> method_table_type;
+typedef scoped_table_type< Symbol, class_tree_node_type> symtable_type;
+typedef scoped_table_type< Symbol, class_method_type> method_table_type;
 
 // Env vars.
-extern method_table_type *method_table;
+extern class_tree_node collecting_class;	// whose methods are being collected
+
+// Counted for COOL_SEMANT_STATS (see semant_stats_report() in
+// semant.cc), through semant_count(), in a build with -DSEMANT_STATS
+// only: in any other the counts cost nothing and stay 0.
+struct semant_stats_type
+{
+  long sub_class_tests;       // is_sub_class_of(), one interval test each
+  long lca_queries;
+  long method_finds;          // find_method() calls
+  long method_cached;         // answered by the class's own cache
+  long homonym_scans;         // answered from methods_by_name
+  long homonyms_scanned;
+  long chain_walks;           // answered by climbing the fathers
+  long chain_steps;
+  long longest_chain;
+  long expr_checks;           // get_Expr_Type() nodes checked
+  long expr_memo_hits;        // nodes found checked already
+};
+extern semant_stats_type semant_stats;
+
+inline void semant_count( long &n, long by = 1)
+{
+#ifdef SEMANT_STATS
+  n += by;
+#else
+  (void) n; (void) by;
+#endif
+}
 
 class ClassTable {
 private:
   int semant_errors;
   void install_basic_classes();
-  ostream& error_stream;
+  ostream* error_stream;
+  std::ostringstream* held;     // errors of a streaming table, until finish()
+  bool closed;              // no more classes are taken after an error
 
   symtable_type symtable;
   symtable_type vartable;
 
+  void begin();
+
 public:
   ClassTable(Classes);
+
+  // Streaming: classes are added one at a time as the parser finishes
+  // them.  Errors are held back until finish() prints them and checks
+  // the whole program, since a later parse error means they don't count.
+  ClassTable();
+  bool add_class(Class_ c);
+  void finish();
+
   int errors() { return semant_errors; }
   ostream& semant_error();
   ostream& semant_error(Class_ c);
   ostream& semant_error(Symbol filename, tree_node *t);
 };
 
+// The methods find_method() has found for a class, its own and the
+// ones it inherits, hashed by name.  Empty until the first is added.
+class method_cache_type
+{
+	struct slot_type
+	{
+		Symbol name;	/* NULL when empty */
+		class_method method;
+	};
+
+	std::vector< slot_type> slots;
+	unsigned used;
+
+	size_t home( Symbol name) const
+	{
+		return ( ( size_t) name >> 4) * 2654435761u & ( slots.size() - 1);
+	}
+
+	slot_type *find( Symbol name)
+	{
+		size_t mask = slots.size() - 1;
+		size_t i = home( name);
+		while ( slots[i].name && slots[i].name != name)
+		{
+			i = ( i + 1) & mask;
+		}
+		return &slots[i];
+	}
+
+	public:
+	method_cache_type() : used( 0) {}
+
+	class_method lookup( Symbol name)
+	{
+		return slots.empty() ? NULL : find( name)->method;
+	}
+
+	void add( Symbol name, class_method method);
+
+	void clear()
+	{
+		slots.clear();
+		used = 0;
+	}
+};
+
 struct class_tree_node_type {
 	class_tree_node set_head;
 	int set_rank;
@@ -61,16 +149,36 @@ struct class_tree_node_type {
 	Class_ contain;
 	int depth;
 
+	// Preorder numbers: a class's subclasses are numbered enter + 1 to
+	// leave.  tour_at is where it first appears in the Euler tour.  All
+	// -1 for a class made after fill_node_depth().
+	int enter;
+	int leave;
+	int tour_at;
+
 	Symbol name;
 
 	static class_tree_node all_node_head;
 	class_tree_node all_node_next;
 
 	method_table_type method_table;
+	method_cache_type methods;
 
+	// Finds the root, then points every class on the way straight at it.
 	class_tree_node find_set()
 	{
-		return set_head == this ? this : set_head = set_head->find_set();
+		class_tree_node root = this;
+		while ( root->set_head != root)
+		{
+			root = root->set_head;
+		}
+		for ( class_tree_node leg = this; leg != root; )
+		{
+			class_tree_node next = leg->set_head;
+			leg->set_head = root;
+			leg = next;
+		}
+		return root;
 	}
 
 	public:
@@ -79,7 +187,8 @@ struct class_tree_node_type {
 	class_tree_node_type( Symbol name, Class_ class_ = NULL) :
 		set_head( this), set_rank( 0), set_size( 1),
 		father( NULL), son( NULL), sibling( NULL),
-		contain( class_), depth( -1), name( name),
+		contain( class_), depth( -1),
+		enter( -1), leave( -1), tour_at( -1), name( name),
 		all_node_next( all_node_head)
 	{
 		all_node_head = this;
@@ -108,38 +217,43 @@ struct class_tree_node_type {
 	void set_contain( Class_ contain)
 	{
 		this->contain = contain;
-		::method_table = &this->method_table;
+		::collecting_class = this;
 		return contain->collect_Methods();
 	}
 
 	bool is_sub_class_of( const class_tree_node_type *super) const
 	{
+		semant_count( semant_stats.sub_class_tests);
 		if ( !is_defined() || !super->is_defined())
 		{
 			return false;
 		}
 
-		const class_tree_node_type *leg = this;
-		while ( leg->depth > super->depth)
-		{
-			leg = leg->father;
-		}
-
-		return leg == super;
+		return this == super ||
+			( super->enter >= 0 && super->enter <= enter && enter <= super->leave);
 	}
 
 	bool is_defined() const;
 
-	class_method find_method( Symbol name)
-	{
-		class_method ret = method_table.lookup( name);
-		return ret ? ret : ( father ? father->find_method( name) : NULL);
-	}
+	void add_method( Symbol name, class_method method);
+	class_method find_method( Symbol name);
 
 	friend class_tree_node find_class_lca( class_tree_node, class_tree_node);
 
 	bool fill_depth();
 
+	// Every class by its enter number; then the Euler tour of the
+	// inheritance forest, and a sparse table over it: row k holds, for
+	// each i, the shallowest class of tour[i] to tour[i + 2^k - 1].  Any
+	// two classes' LCA is the shallowest one between their tour_at,
+	// found from two overlapping rows.
+	static std::vector< class_tree_node> preorder;
+	static std::vector< class_tree_node> tour;
+	static std::vector< class_tree_node> lca_table;
+	static std::vector< int> lca_log;
+
+	static void number_nodes();
+
 	static void fill_node_depth()
 	{
 		class_tree_node leg = all_node_head;
@@ -148,27 +262,56 @@ struct class_tree_node_type {
 			leg->fill_depth();
 			leg = leg->all_node_next;
 		}
+		number_nodes();
 	}
 
+	void check_in_scope();
 	bool walk_down();
 };
 
+// An expression part way through Expression_class::get_Expr_Type().
+// Each check_Expr_Step() call runs the node's check up to the next
+// subexpression it needs, and returns that subexpression; its type is
+// in `sub' on the next call.  The last step returns NULL with the
+// node's own type in `ret'.  The other fields hold what the check had
+// in local variables.
+struct check_frame_type
+{
+	Expression expr;
+	int step;
+	Type sub;
+	Type ret;
+
+	int i;
+	Type a;
+	Type b;
+	class_method types;
+	int formal;
+
+	check_frame_type( Expression e) : expr( e), step( 0), i( 0), types( NULL), formal( 0) {}
+};
+
+// A method's signature: its return type, then the type of each formal.
 struct class_method_type
 {
 	private:
-	Type type;
-	class_method next;
+	int formals;
+	Type *types;
 
 	public:
-	class_method_type( Type nt, class_method nn = NULL) : type( nt), next( nn) {}
+	class_tree_node owner;	// the class that defines it
+	class_method homonym;	// the last method of the same name before it, in any class
+	int homonyms;			// how many methods of the name there are, this one included
 
-	Type hd() const { return type;}
-	class_method tl() const { return next;}
+	class_method_type( int formals) : formals( formals), types( new Type[formals + 1]),
+		owner( NULL), homonym( NULL), homonyms( 1) {}
 
-	void set_hd( Type nt) { type = nt;}
-	void set_tl( class_method nn) { next = nn;}
+	Type return_type() const { return types[0];}
+	int formal_count() const { return formals;}
+	Type formal( int i) const { return types[i + 1];}
 
-	bool is_defined() const { return type; }
+	void set_return_type( Type t) { types[0] = t;}
+	void set_formal( int i, Type t) { types[i + 1] = t;}
 
 	bool same_method( class_method t) const;
 };
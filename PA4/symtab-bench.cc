@@ -0,0 +1,128 @@
+/*
+ *  Symbol table benchmark.
+ *
+ *  Times SymbolTable (symtab.h) against scoped_table_type
+ *  (scoped-table.h) on the two shapes semant's tables take, for
+ *  doubling sizes:
+ *
+ *    attrs   a class scope of n attributes, each looked up from inside
+ *            the method, formal and let scopes under it
+ *    scopes  n nested scopes of one variable each, as a chain of lets,
+ *            the outermost one looked up from each
+ *
+ *  Both are quadratic with SymbolTable, whose lookups search every
+ *  entry in scope; the time per operation of the other should stay
+ *  flat.
+ *
+ *    symtab-bench [max-size]
+ *
+ *  Build it next to semant.cc:
+ *
+ *    g++ -g -O2 -I. -I../../include/PA4 symtab-bench.cc \
+ *        ../../src/PA4/stringtab.cc ../../src/PA4/utilities.cc -o symtab-bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <vector>
+
+#include "stringtab.h"
+#include "symtab.h"
+#include "scoped-table.h"
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static int info;
+
+/* n lookups of attributes, from three scopes down. */
+template <class Table> static double attrs( const std::vector< Symbol> &names, int n)
+{
+	Table table;
+	double start = now();
+	table.enterscope();
+	for ( int i = 0; i < n; ++i)
+	{
+		table.addid( names[i], &info);
+	}
+	for ( int scope = 0; scope < 3; ++scope)
+	{
+		table.enterscope();
+		table.addid( names[names.size() - 1 - scope], &info);
+	}
+
+	long found = 0;
+	for ( int i = 0; i < n; ++i)
+	{
+		found += table.lookup( names[( i * 7919L) % n]) != NULL;
+	}
+
+	for ( int scope = 0; scope < 4; ++scope)
+	{
+		table.exitscope();
+	}
+	if ( found != n)
+	{
+		fprintf( stderr, "symtab-bench: lost an attribute\n");
+		exit( 1);
+	}
+	return ( now() - start) / n;
+}
+
+/* n nested scopes, each adding one name and looking up the first. */
+template <class Table> static double scopes( const std::vector< Symbol> &names, int n)
+{
+	Table table;
+	double start = now();
+	long found = 0;
+	for ( int i = 0; i < n; ++i)
+	{
+		table.enterscope();
+		table.addid( names[i], &info);
+		found += table.lookup( names[0]) != NULL;
+		found += table.probe( names[i]) != NULL;
+	}
+	for ( int i = 0; i < n; ++i)
+	{
+		table.exitscope();
+	}
+	if ( found != 2L * n)
+	{
+		fprintf( stderr, "symtab-bench: lost a variable\n");
+		exit( 1);
+	}
+	return ( now() - start) / n;
+}
+
+int main( int argc, char **argv)
+{
+	int max = argc > 1 ? atoi( argv[1]) : 1 << 16;
+
+	// Made directly: idtable would search its list for each.
+	std::vector< Symbol> names;
+	for ( int i = 0; i < max; ++i)
+	{
+		char name[16];
+		int len = sprintf( name, "v%d", i);
+		names.push_back( new IdEntry( name, len, i));
+	}
+
+	typedef SymbolTable< Symbol, int> list_table;
+	typedef scoped_table_type< Symbol, int> hash_table;
+
+	printf( "%10s %14s %14s %14s %14s\n", "size", "attrs list ns", "attrs hash ns",
+			"scopes list ns", "scopes hash ns");
+	for ( int n = 1024; n <= max; n *= 2)
+	{
+		printf( "%10d %14.1f %14.1f %14.1f %14.1f\n", n,
+				attrs< list_table>( names, n) * 1e9, attrs< hash_table>( names, n) * 1e9,
+				scopes< list_table>( names, n) * 1e9, scopes< hash_table>( names, n) * 1e9);
+		fflush( stdout);
+	}
+	return 0;
+}
@@ -0,0 +1,374 @@
+#ifndef TREE_NODE_H
+#define TREE_NODE_H
+///////////////////////////////////////////////////////////////////////////
+//
+// file: tree-node.h
+//
+// This file defines the basic class of tree node and list.
+//
+// It takes the place of the course's tree.h.  tree_node and the list
+// API are unchanged; what differs is the list representation, see
+// list_node below, and where nodes are allocated, see tree_arena.
+//
+// Every file of a program must see this header and not the course's,
+// the course's tree.cc and cool-tree.cc included, which ask for
+// "tree.h".  So the files are built with -include tree-node.h, and
+// this header defines TREE_H, the course header's guard, which leaves
+// the course header empty wherever it is included later.  Should the
+// course header still come first, the build stops here.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifdef TREE_H
+#error "the course's tree.h was included before tree-node.h; build with -include tree-node.h"
+#endif
+#define TREE_H
+
+#include <stdlib.h>
+#include <new>
+#include <vector>
+#include "cool.h"
+#include "stringtab.h"
+
+
+/////////////////////////////////////////////////////////////////////
+// tree_node
+//
+// All APS nodes are derived from tree_node.  The protected field
+// line_number is the line in the source file the node came from; the
+// constructor takes it from node_lineno, which the parser keeps set.
+/////////////////////////////////////////////////////////////////////
+class tree_node {
+protected:
+    int line_number;            // stash the line number when node is made
+public:
+    tree_node();
+    virtual tree_node *copy() = 0;
+    virtual ~tree_node() { }
+    virtual void dump(ostream& stream, int n) = 0;
+    int get_line_number();
+    tree_node *set(tree_node *);
+
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+};
+
+extern int node_lineno;
+
+
+/////////////////////////////////////////////////////////////////////
+// tree_arena
+//
+// While a thread has the arena open, the nodes it makes are cut one
+// after another from large malloc'ed blocks instead of being malloc'ed
+// one by one; coolc's parser opens it for the length of each parse.
+// Nothing takes the tree apart node by node, so the nodes in the arena
+// are freed all at once, by release() at the end of the compile, and
+// no destructor runs for them.  One thread at a time may have it open.
+// Nodes made with the arena closed are malloc'ed as before.
+/////////////////////////////////////////////////////////////////////
+#define TREE_ARENA
+
+class tree_arena {
+    struct block {
+	block *next;
+	char *cur;
+	char *end;
+    };
+    enum { align = 16, first_size = 1 << 16, last_size = 1 << 24 };
+
+    static block *&blocks()	{ static block *head = NULL; return head; }
+    static int &open_here()	{ static __thread int on; return on; }
+    static size_t header()	{ return (sizeof(block) + align - 1) & ~(size_t) (align - 1); }
+    static char *start(block *b)	{ return (char *) b + header(); }
+
+public:
+    static void open()		{ open_here() = 1; }
+    static void close()		{ open_here() = 0; }
+
+    // Nodes made by this thread, and their bytes, in the arena or not.
+    static long &nodes()	{ static __thread long n; return n; }
+    static size_t &bytes()	{ static __thread size_t n; return n; }
+
+    static void *alloc(size_t size);
+    static bool owns(void *p);
+    static void release();
+};
+
+// NULL when the arena isn't open on this thread.
+inline void *tree_arena::alloc(size_t size)
+{
+    ++nodes();
+    bytes() += size;
+    if (!open_here())
+	return NULL;
+
+    size = (size + align - 1) & ~(size_t) (align - 1);
+    block *b = blocks();
+    if (!b || size > (size_t) (b->end - b->cur)) {
+	// Each block is twice the last, up to last_size.
+	size_t want = b ? 2 * (b->end - (char *) b) : first_size;
+	if (want > last_size)
+	    want = last_size;
+	if (want < header() + size)
+	    want = header() + size;
+	block *fresh = (block *) malloc(want);
+	if (!fresh)
+	    return NULL;
+	fresh->next = b;
+	fresh->cur = start(fresh);
+	fresh->end = (char *) fresh + want;
+	blocks() = b = fresh;
+    }
+    void *p = b->cur;
+    b->cur += size;
+    return p;
+}
+
+inline bool tree_arena::owns(void *p)
+{
+    for (block *b = blocks(); b; b = b->next)
+	if ((char *) p >= start(b) && (char *) p < b->end)
+	    return true;
+    return false;
+}
+
+inline void tree_arena::release()
+{
+    while (block *b = blocks()) {
+	blocks() = b->next;
+	free(b);
+    }
+}
+
+inline void *tree_node::operator new(size_t size)
+{
+    void *p = tree_arena::alloc(size);
+    if (!p)
+	p = malloc(size ? size : 1);
+    if (!p)
+	throw std::bad_alloc();
+    return p;
+}
+
+inline void tree_node::operator delete(void *p)
+{
+    if (!tree_arena::owns(p))
+	free(p);
+}
+
+char *pad(int n);
+
+
+///////////////////////////////////////////////////////////////////
+// Lists of APS objects.
+//
+// The parser builds a list of n elements as n nested append nodes, so
+// walking it with
+//
+//	for ( i = l->first(); l->more( i); i = l->next( i))
+//		... l->nth( i) ...
+//
+// used to cost O(n) per nth() and per more(), O(n^2) in all.  Lists
+// never change once built, so the first nth() or len() now copies the
+// elements into one array, iteratively, and every later call is an
+// index into it.  A sublist that was flattened before is copied from
+// its array rather than walked again.
+///////////////////////////////////////////////////////////////////
+
+template <class Elem> class list_node : public tree_node {
+    Elem *elems;                // every element in order, once flattened
+    int count;                  // -1 until then
+
+    void flatten();
+
+protected:
+    // Adds what this node holds to a flattening in progress: elements
+    // go to out, sublists onto todo, last one first.
+    virtual void parts(std::vector<Elem> &out,
+                       std::vector<list_node<Elem> *> &todo) = 0;
+
+public:
+    list_node() : elems(NULL), count(-1) { }
+    tree_node *copy()		 { return copy_list(); }
+    Elem nth(int n);
+    //
+    // The next three functions define a simple iterator.
+    //
+    int first()      { return 0; }
+    int next(int n)  { return n + 1; }
+    int more(int n)  { return (n < len()); }
+
+    virtual list_node<Elem> *copy_list() = 0;
+    virtual ~list_node() { delete [] elems; }
+    int len()
+    {
+	if (count < 0)
+	    flatten();
+	return count;
+    }
+
+    static list_node<Elem> *nil();
+    static list_node<Elem> *single(Elem);
+    static list_node<Elem> *append(list_node<Elem> *l1,list_node<Elem> *l2);
+};
+
+template <class Elem> class nil_node : public list_node<Elem> {
+protected:
+    void parts(std::vector<Elem> &, std::vector<list_node<Elem> *> &) { }
+public:
+    list_node<Elem> *copy_list();
+    void dump(ostream& stream, int n);
+};
+
+template <class Elem> class single_list_node : public list_node<Elem> {
+    Elem elem;
+protected:
+    void parts(std::vector<Elem> &out, std::vector<list_node<Elem> *> &)
+    {
+	out.push_back(elem);
+    }
+public:
+    single_list_node(Elem t) {
+	elem = t;
+    }
+    list_node<Elem> *copy_list();
+    void dump(ostream& stream, int n);
+};
+
+template <class Elem> class append_node : public list_node<Elem> {
+private:
+    list_node<Elem> *some, *rest;
+protected:
+    void parts(std::vector<Elem> &, std::vector<list_node<Elem> *> &todo)
+    {
+	todo.push_back(rest);
+	todo.push_back(some);
+    }
+public:
+    append_node(list_node<Elem> *l1, list_node<Elem> *l2) {
+	some = l1;
+	rest = l2;
+    }
+    list_node<Elem> *copy_list();
+    void dump(ostream& stream, int n);
+};
+
+template <class Elem> single_list_node<Elem> *list(Elem x);
+template <class Elem> append_node<Elem> *cons(Elem x, list_node<Elem> *l);
+template <class Elem> append_node<Elem> *xcons(list_node<Elem> *l, Elem x);
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// list_node
+//
+///////////////////////////////////////////////////////////////////////////
+
+template <class Elem> list_node<Elem> *list_node<Elem>::nil()
+{
+    return new nil_node<Elem>();
+}
+
+template <class Elem> list_node<Elem> *list_node<Elem>::single(Elem e)
+{
+    return new single_list_node<Elem>(e);
+}
+
+template <class Elem> list_node<Elem> *list_node<Elem>::append(list_node<Elem> *l1,list_node<Elem> *l2)
+{
+    return new append_node<Elem>(l1,l2);
+}
+
+template <class Elem> void list_node<Elem>::flatten()
+{
+    std::vector<Elem> out;
+    std::vector<list_node<Elem> *> todo(1, this);
+    while (!todo.empty()) {
+	list_node<Elem> *l = todo.back();
+	todo.pop_back();
+	if (l->count >= 0)
+	    out.insert(out.end(), l->elems, l->elems + l->count);
+	else
+	    l->parts(out, todo);
+    }
+
+    elems = new Elem[out.size() ? out.size() : 1];
+    for (size_t i = 0; i < out.size(); i++)
+	elems[i] = out[i];
+    count = out.size();
+}
+
+template <class Elem> Elem list_node<Elem>::nth(int n)
+{
+    if (n >= 0 && n < len())
+	return elems[n];
+    cerr << "error: outside the range of the list\n";
+    exit(1);
+}
+
+///////////////////////////////////////////////////////////////////////////
+//
+// nil_node
+//
+///////////////////////////////////////////////////////////////////////////
+
+template <class Elem> list_node<Elem> *nil_node<Elem>::copy_list()
+{
+    return new nil_node<Elem>();
+}
+
+template <class Elem> void nil_node<Elem>::dump(ostream& stream, int n)
+{
+    stream << pad(n) << "(nil)\n";
+}
+
+///////////////////////////////////////////////////////////////////////////
+//
+// single_list_node
+//
+///////////////////////////////////////////////////////////////////////////
+
+template <class Elem> list_node<Elem> *single_list_node<Elem>::copy_list()
+{
+    return new single_list_node<Elem>((Elem) elem->copy());
+}
+
+template <class Elem> void single_list_node<Elem>::dump(ostream& stream, int n)
+{
+    elem->dump(stream, n);
+}
+
+///////////////////////////////////////////////////////////////////////////
+//
+// append_node
+//
+///////////////////////////////////////////////////////////////////////////
+
+template <class Elem> list_node<Elem> *append_node<Elem>::copy_list()
+{
+    return new append_node<Elem>(some->copy_list(), rest->copy_list());
+}
+
+template <class Elem> void append_node<Elem>::dump(ostream& stream, int n)
+{
+    some->dump(stream, n);
+    rest->dump(stream, n);
+}
+
+template <class Elem> single_list_node<Elem> *list(Elem x)
+{
+    return new single_list_node<Elem>(x);
+}
+
+template <class Elem> append_node<Elem> *cons(Elem x, list_node<Elem> *l)
+{
+    return new append_node<Elem>(list(x), l);
+}
+
+template <class Elem> append_node<Elem> *xcons(list_node<Elem> *l, Elem x)
+{
+    return new append_node<Elem>(l, list(x));
+}
+
+#endif
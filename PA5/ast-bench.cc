@@ -0,0 +1,117 @@
+/*
+ *  AST interchange benchmark.
+ *
+ *  Reads a typed AST in the text format from stdin, the way cgen gets
+ *  it, then times writing and reading it back as text (dump_with_types
+ *  and ast_yyparse) and as a binary AST file (ast-binary.h).
+ *
+ *    lexer big.cl | parser | semant | ast-bench [reps]
+ *
+ *  Build it next to cgen, from the files the cgen Makefile uses:
+ *
+ *    g++ -g -O2 -I. -I../PA4 -I../../include/PA5 -I../../src/PA5 -include tree-node.h \
+ *        ast-bench.cc ast-lex.cc ast-parse.cc utilities.cc stringtab.cc dumptype.cc \
+ *        tree.cc cool-tree.cc handle_flags.cc cgen.cc cgen_supp.cc -o ast-bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <fstream>
+
+#include "cool-tree.h"
+#include "../PA4/ast-binary.h"
+
+extern int ast_yyparse( void);
+extern void ast_yyrestart( FILE *);
+extern Program ast_root;
+extern int omerrs;
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static long file_size( const char *path)
+{
+	struct stat st;
+	return stat( path, &st) == 0 ? st.st_size : -1;
+}
+
+static void report( const char *what, double secs, int reps)
+{
+	printf( "  %-14s %8.3fs\n", what, secs / reps);
+}
+
+int main( int argc, char **argv)
+{
+	int reps = argc > 1 ? atoi( argv[1]) : 3;
+
+	ast_yyparse();
+	if ( omerrs != 0 || !ast_root)
+	{
+		cerr << "ast-bench: can't read the AST on stdin" << endl;
+		return 1;
+	}
+	Program program = ast_root;
+
+	char text_path[] = "/tmp/ast-bench.XXXXXX";
+	char binary_path[] = "/tmp/ast-bench.XXXXXX";
+	int text_fd = mkstemp( text_path);
+	int binary_fd = mkstemp( binary_path);
+	if ( text_fd < 0 || binary_fd < 0)
+	{
+		perror( "mkstemp");
+		return 1;
+	}
+	close( text_fd);
+	close( binary_fd);
+
+	double text_write = 0, text_read = 0, binary_write = 0, binary_read = 0;
+	for ( int r = 0; r < reps; ++r)
+	{
+		double start = now();
+		{
+			std::ofstream out( text_path);
+			program->dump_with_types( out, 0);
+		}
+		text_write += now() - start;
+
+		start = now();
+		FILE *in = fopen( text_path, "r");
+		ast_yyrestart( in);
+		ast_yyparse();
+		fclose( in);
+		text_read += now() - start;
+
+		start = now();
+		if ( !ast_binary_write( program, binary_path))
+		{
+			perror( binary_path);
+			return 1;
+		}
+		binary_write += now() - start;
+
+		start = now();
+		if ( !ast_binary_read( binary_path))
+		{
+			cerr << "ast-bench: can't read back " << binary_path << endl;
+			return 1;
+		}
+		binary_read += now() - start;
+	}
+
+	printf( "text:   %ld bytes\n", file_size( text_path));
+	report( "write", text_write, reps);
+	report( "read", text_read, reps);
+	printf( "binary: %ld bytes\n", file_size( binary_path));
+	report( "write", binary_write, reps);
+	report( "read", binary_read, reps);
+
+	unlink( text_path);
+	unlink( binary_path);
+	return 0;
+}
@@ -1336,30 +1336,141 @@ int method_class::get_temp_size() {
 	return expr->get_temp_size();
 }
 
-void assign_class::code(ostream &s) {
-	expr->code( s);
+//
+// Expressions are coded and sized with a stack of their own rather
+// than the C stack, so that nesting is only limited by memory.  Each
+// node's code() is split into steps by code_step(), and its
+// get_temp_size() by temp_size_step(): a step returns the
+// subexpression to do next, and the node is called again once that is
+// done (see code_frame_type and temp_frame_type in cgen.h).
+//
+void Expression_class::code(ostream &s) {
+	std::vector< code_frame_type> stack;
+	stack.push_back( code_frame_type( this));
+	while ( !stack.empty())
+	{
+		code_frame_type &f = stack.back();
+		Expression next = f.expr->code_step( f, s);
+		if ( next)
+		{
+			stack.push_back( code_frame_type( next));
+		}
+		else
+		{
+			stack.pop_back();
+		}
+	}
+}
+
+int Expression_class::get_temp_size() {
+	std::vector< temp_frame_type> stack;
+	stack.push_back( temp_frame_type( this));
+	int size = 0;
+	while ( !stack.empty())
+	{
+		temp_frame_type &f = stack.back();
+		Expression next = f.expr->temp_size_step( f);
+		if ( next)
+		{
+			stack.push_back( temp_frame_type( next));
+			continue;
+		}
+
+		size = f.size;
+		stack.pop_back();
+		if ( !stack.empty())
+		{
+			stack.back().sub = size;
+		}
+	}
+	return size;
+}
+
+Expression assign_class::code_step( code_frame_type &f, ostream &s) {
+	if ( f.step++ == 0)
+	{
+		return expr;
+	}
 	lookup_var( name);
 	emit_store( ACC, object_offset, object_base_reg, s);
 	expr_is_const = 1;
+	return NULL;
 }
 
-int assign_class::get_temp_size() {
-	return expr->get_temp_size();
+Expression assign_class::temp_size_step( temp_frame_type &f) {
+	if ( f.step++ == 0)
+	{
+		return expr;
+	}
+	f.size = f.sub;
+	return NULL;
 }
 
-void static_dispatch_class::code(ostream &s) {
-	Symbol type = type_name;
-	if ( type == SELF_TYPE)
+//
+// Codes a dispatch's actuals, each pushed in turn, then the object
+// dispatched to; NULL once they are all done.
+//
+static Expression code_actuals( code_frame_type &f, Expressions actual, Expression expr, ostream &s)
+{
+	switch ( f.step)
 	{
-		type = global_node->get_name();
+	case 0:
+		f.i = actual->first();
+		break;
+	case 1:
+		emit_push( ACC, s);
+		f.i = actual->next( f.i);
+		break;
+	default:
+		return NULL;
 	}
 
-	for ( int i = actual->first(); actual->more( i); i = actual->next( i))
+	if ( actual->more( f.i))
 	{
-		actual->nth( i)->code( s);
-		emit_push( ACC, s);
+		f.step = 1;
+		return actual->nth( f.i);
+	}
+	f.step = 2;
+	return expr;
+}
+
+//
+// The largest temp size of the object dispatched to and the actuals.
+//
+static Expression actuals_temp_size( temp_frame_type &f, Expressions actual, Expression expr)
+{
+	if ( f.step == 0)
+	{
+		f.step = 1;
+		f.i = actual->first();
+		return expr;
+	}
+
+	f.size = max( f.size, f.sub);
+	if ( f.step == 2)
+	{
+		f.i = actual->next( f.i);
+	}
+	if ( actual->more( f.i))
+	{
+		f.step = 2;
+		return actual->nth( f.i);
+	}
+	return NULL;
+}
+
+Expression static_dispatch_class::code_step( code_frame_type &f, ostream &s) {
+	Expression next = code_actuals( f, actual, expr, s);
+	if ( next)
+	{
+		return next;
+	}
+
+	Symbol type = type_name;
+	if ( type == SELF_TYPE)
+	{
+		type = global_node->get_name();
 	}
-	expr->code( s);
 
 	int good_label = new_label();
 	emit_abort( good_label, line_number, DISPATHABORT, s);
@@ -1373,31 +1484,26 @@ void static_dispatch_class::code(ostream &s) {
 	emit_jalr( T0, s);
 
 	expr_is_const = 1;
+	return NULL;
+}
+
+Expression static_dispatch_class::temp_size_step( temp_frame_type &f) {
+	return actuals_temp_size( f, actual, expr);
 }
 
-int static_dispatch_class::get_temp_size() {
-	int ret = expr->get_temp_size();
-	for ( int i = actual->first(); actual->more( i); i = actual->next( i))
+Expression dispatch_class::code_step( code_frame_type &f, ostream &s) {
+	Expression next = code_actuals( f, actual, expr, s);
+	if ( next)
 	{
-		ret = max( ret, actual->nth( i)->get_temp_size());
+		return next;
 	}
-	return ret;
-}
 
-void dispatch_class::code(ostream &s) {
 	Symbol type = expr->get_type();
 	if ( type == SELF_TYPE)
 	{
 		type = global_node->get_name();
 	}
 
-	for ( int i = actual->first(); actual->more( i); i = actual->next( i))
-	{
-		actual->nth( i)->code( s);
-		emit_push( ACC, s);
-	}
-	expr->code( s);
-
 	int good_label = new_label();
 	emit_abort( good_label, line_number, DISPATHABORT, s);
 
@@ -1412,196 +1518,319 @@ void dispatch_class::code(ostream &s) {
 	expr_is_const = 1;
 	if ( cgen_debug)
 		cout  << "Dispatch " << name << " is const ? " << bool(expr_is_const) << endl;
+	return NULL;
 }
 
-int dispatch_class::get_temp_size() {
-	int ret = expr->get_temp_size();
-	for ( int i = actual->first(); actual->more( i); i = actual->next( i))
-	{
-		ret = max( ret, actual->nth( i)->get_temp_size());
-	}
-	return ret;
+Expression dispatch_class::temp_size_step( temp_frame_type &f) {
+	return actuals_temp_size( f, actual, expr);
 }
 
-void cond_class::code(ostream &s) {
-	int else_label = new_label();
-	int end_label = new_label();
+Expression cond_class::code_step( code_frame_type &f, ostream &s) {
+	switch ( f.step++)
+	{
+	case 0:
+		f.label = new_label();
+		f.end_label = new_label();
 
-	if ( cgen_debug)
-		cout << "Generating if end at " << end_label << endl;
-	pred->code( s);
-	emit_load_bool( T0, falsebool, s);
-	emit_beq( ACC, T0, else_label, s);
-	then_exp->code( s);
-	emit_branch( end_label, s);
-	emit_label_def( else_label, s);
-	else_exp->code( s);
-	emit_label_def( end_label, s);
+		if ( cgen_debug)
+			cout << "Generating if end at " << f.end_label << endl;
+		return pred;
+	case 1:
+		emit_load_bool( T0, falsebool, s);
+		emit_beq( ACC, T0, f.label, s);
+		return then_exp;
+	case 2:
+		emit_branch( f.end_label, s);
+		emit_label_def( f.label, s);
+		return else_exp;
+	}
+	emit_label_def( f.end_label, s);
 
 	expr_is_const = 1;
+	return NULL;
 }
 
-int cond_class::get_temp_size() {
-	return max( pred->get_temp_size(),
-			max( then_exp->get_temp_size(), else_exp->get_temp_size()));
+Expression cond_class::temp_size_step( temp_frame_type &f) {
+	switch ( f.step++)
+	{
+	case 0:
+		return pred;
+	case 1:
+		f.size = f.sub;
+		return then_exp;
+	case 2:
+		f.size = max( f.size, f.sub);
+		return else_exp;
+	}
+	f.size = max( f.size, f.sub);
+	return NULL;
 }
 
-void loop_class::code(ostream &s) {
-	int cond_label = new_label();
-	int end_label = new_label();
-
-	emit_label_def( cond_label, s);
-	pred->code( s);
-	emit_load_bool( T0, falsebool, s);
-	emit_beq( ACC, T0, end_label, s);
-	body->code( s);
-	emit_branch( cond_label, s);
-	emit_label_def( end_label, s);
+Expression loop_class::code_step( code_frame_type &f, ostream &s) {
+	switch ( f.step++)
+	{
+	case 0:
+		f.label = new_label();
+		f.end_label = new_label();
+
+		emit_label_def( f.label, s);
+		return pred;
+	case 1:
+		emit_load_bool( T0, falsebool, s);
+		emit_beq( ACC, T0, f.end_label, s);
+		return body;
+	}
+	emit_branch( f.label, s);
+	emit_label_def( f.end_label, s);
 
 	// Return void dear.
 	emit_move( ACC, ZERO, s);
 	expr_is_const = 1;
+	return NULL;
 }
 
-int loop_class::get_temp_size() {
-	return max( pred->get_temp_size(), body->get_temp_size());
+Expression loop_class::temp_size_step( temp_frame_type &f) {
+	switch ( f.step++)
+	{
+	case 0:
+		return pred;
+	case 1:
+		f.size = f.sub;
+		return body;
+	}
+	f.size = max( f.size, f.sub);
+	return NULL;
 }
 
-void typcase_class::code(ostream &s) {
-	expr->code( s);
+//
+// The branches are coded in the order of the sorted tag ranges, which
+// the frame keeps: the one table in cgen_supp.cc is refilled by any
+// case nested in a branch.
+//
+Expression typcase_class::code_step( code_frame_type &f, ostream &s) {
+	if ( f.step == 0)
+	{
+		f.step = 1;
+		return expr;
+	}
 
-	int last_label = new_label();
-	emit_abort( last_label, line_number, CASEABORT2, s);
-	emit_label_def( last_label, s);
-	emit_load( T0, TAG_OFFSET, ACC, s);
-	last_label = new_label();
+	if ( f.step == 1)
+	{
+		int last_label = new_label();
+		emit_abort( last_label, line_number, CASEABORT2, s);
+		emit_label_def( last_label, s);
+		emit_load( T0, TAG_OFFSET, ACC, s);
+		f.end_label = new_label();
 
-	int temp = alloc_temp() + DEFAULT_FRAME_OFFSET;
+		f.temp = alloc_temp() + DEFAULT_FRAME_OFFSET;
 
-	emit_store( ACC, temp, FP, s);
+		emit_store( ACC, f.temp, FP, s);
 
-	if ( cgen_debug)
-		cout << "First label should be " << last_label << endl;
+		if ( cgen_debug)
+			cout << "First label should be " << f.end_label << endl;
 
-	clear_vec();
-	for ( int i( cases->first()); cases->more( i); i = cases->next( i))
-	{
-		Symbol type = cases->nth( i)->get_type_decl();
+		clear_vec();
+		for ( int i( cases->first()); cases->more( i); i = cases->next( i))
+		{
+			Symbol type = cases->nth( i)->get_type_decl();
+
+			CgenNodeP class_node = global_table->lookup( type);
+			push_vec( class_node->get_class_tag(), class_node->get_max_class_tag(), i);
+			if ( cgen_debug)
+				cout << " Coding case with class " << type << " tag " << class_node->get_class_tag() << endl;
+		}
+
+		sort_vec();
 
-		CgenNodeP class_node = global_table->lookup( type);
-		push_vec( class_node->get_class_tag(), class_node->get_max_class_tag(), i);
 		if ( cgen_debug)
-			cout << " Coding case with class " << type << " tag " << class_node->get_class_tag() << endl;
-	}
+			cout << "Coding table, first label should be " << f.end_label << endl;
 
-	sort_vec();
+		for ( init_vec(); next_vec(); )
+		{
+			case_range_type range;
+			fetch_vec( range.x, range.y, range.c);
+			f.cases.push_back( range);
+		}
 
-	if ( cgen_debug)
-		cout << "Coding table, first label should be " << last_label << endl;
+		f.label = new_label();
+		f.i = 0;
+		f.step = 2;
+	}
+	else
+	{
+		method_var_table->exitscope();
+		emit_branch( f.end_label, s);
+		++f.i;
+	}
 
-	int x, y, c, cur_label, next_label = new_label();
-	for ( init_vec(); next_vec(); )
+	if ( f.i < ( int) f.cases.size())
 	{
-		fetch_vec( x, y, c);
+		int x = f.cases[f.i].x, y = f.cases[f.i].y, c = f.cases[f.i].c;
 		if ( cgen_debug)
 			cout << " Coding case branch tags " << x << " " << y << endl;
-		cur_label = next_label;
-		next_label = new_label();
+		int cur_label = f.label;
+		f.label = new_label();
 		if ( cgen_debug)
-			cout << "Coding case branch " << cur_label << " next " << next_label << endl;
+			cout << "Coding case branch " << cur_label << " next " << f.label << endl;
 		emit_label_def( cur_label, s);
-		emit_blti( T0, x, next_label, s);
-		emit_bgti( T0, y, next_label, s);
+		emit_blti( T0, x, f.label, s);
+		emit_bgti( T0, y, f.label, s);
 
 		Case br = cases->nth( c);
 		method_var_table->enterscope();
-		method_var_table->addid( br->get_name(), ( void *)( temp));
-		br->get_expr()->code( s);
-		method_var_table->exitscope();
-		emit_branch( last_label, s);
+		method_var_table->addid( br->get_name(), ( void *)( f.temp));
+		return br->get_expr();
 	}
 
-	emit_label_def( next_label, s);
+	emit_label_def( f.label, s);
 	emit_jal( CASEABORT, s);
 
-	emit_label_def( last_label, s);
+	emit_label_def( f.end_label, s);
 	expr_is_const = 1;
+	return NULL;
 }
 
-int typcase_class::get_temp_size() {
-	int cnt = expr->get_temp_size();
-	for ( int i( cases->first()); cases->more( i); i = cases->next( i))
+Expression typcase_class::temp_size_step( temp_frame_type &f) {
+	if ( f.step == 0)
 	{
-		cnt = max( cnt, cases->nth( i)->get_expr()->get_temp_size() + 1);
+		f.step = 1;
+		return expr;
 	}
 
-	return cnt;
-}
-
-void block_class::code(ostream &s) {
-	for ( int i( body->first()); body->more( i); i = body->next( i))
+	if ( f.step == 1)
 	{
-		body->nth( i)->code( s);
+		f.size = f.sub;
+		f.i = cases->first();
+		f.step = 2;
 	}
-}
-
-int block_class::get_temp_size() {
-	int ret = 0;
-	for ( int i( body->first()); body->more( i); i = body->next( i))
+	else
 	{
-		ret = max( ret, body->nth( i)->get_temp_size());
+		f.size = max( f.size, f.sub + 1);
+		f.i = cases->next( f.i);
 	}
-	return ret;
+	return cases->more( f.i) ? cases->nth( f.i)->get_expr() : NULL;
 }
 
-void let_class::code(ostream &s) {
-	int offset = alloc_temp() + DEFAULT_FRAME_OFFSET;
-	if ( init->get_type())
+Expression block_class::code_step( code_frame_type &f, ostream &s) {
+	f.i = f.step++ == 0 ? body->first() : body->next( f.i);
+	return body->more( f.i) ? body->nth( f.i) : NULL;
+}
+
+Expression block_class::temp_size_step( temp_frame_type &f) {
+	if ( f.step++ == 0)
 	{
-		init->code( s);
+		f.i = body->first();
 	}
 	else
 	{
-		if ( type_decl == Int)
+		f.size = max( f.size, f.sub);
+		f.i = body->next( f.i);
+	}
+	return body->more( f.i) ? body->nth( f.i) : NULL;
+}
+
+Expression let_class::code_step( code_frame_type &f, ostream &s) {
+	if ( f.step == 0)
+	{
+		f.temp = alloc_temp() + DEFAULT_FRAME_OFFSET;
+		f.step = 1;
+		if ( init->get_type())
 		{
-			emit_load_int( ACC, inttable.lookup_string( "0"), s);
+			return init;
 		}
 		else
 		{
-			if ( type_decl == Bool)
+			if ( type_decl == Int)
 			{
-				emit_load_bool( ACC, falsebool, s);
+				emit_load_int( ACC, inttable.lookup_string( ( char *) "0"), s);
 			}
 			else
 			{
-				if ( type_decl == Str)
+				if ( type_decl == Bool)
 				{
-					emit_load_string( ACC, stringtable.lookup_string( ""), s);
+					emit_load_bool( ACC, falsebool, s);
 				}
 				else
 				{
-					init->code( s);
+					if ( type_decl == Str)
+					{
+						emit_load_string( ACC, stringtable.lookup_string( ( char *) ""), s);
+					}
+					else
+					{
+						return init;
+					}
 				}
 			}
 		}
 	}
-	emit_store( ACC, offset, FP, s);
-	method_var_table->enterscope();
-	method_var_table->addid( identifier, ( void *)( offset));
-	body->code( s);
+
+	if ( f.step == 1)
+	{
+		emit_store( ACC, f.temp, FP, s);
+		method_var_table->enterscope();
+		method_var_table->addid( identifier, ( void *)( f.temp));
+		f.step = 2;
+		return body;
+	}
+
 	method_var_table->exitscope();
+	return NULL;
 }
 
-int let_class::get_temp_size() {
-	return max( init->get_temp_size(), body->get_temp_size() + 1);
+Expression let_class::temp_size_step( temp_frame_type &f) {
+	switch ( f.step++)
+	{
+	case 0:
+		return init;
+	case 1:
+		f.size = f.sub;
+		return body;
+	}
+	f.size = max( f.size, f.sub + 1);
+	return NULL;
+}
+
+//
+// The temp size of a node with two subexpressions whose second one
+// needs a temp over the first's result.
+//
+static Expression binary_temp_size( temp_frame_type &f, Expression e1, Expression e2)
+{
+	switch ( f.step++)
+	{
+	case 0:
+		return e1;
+	case 1:
+		f.size = f.sub;
+		return e2;
+	}
+	f.size = max( f.size, f.sub + 1);
+	return NULL;
 }
 
-#define ARITH_CODE( cmd, s)\
+static Expression unary_temp_size( temp_frame_type &f, Expression e1)
+{
+	if ( f.step++ == 0)
+	{
+		return e1;
+	}
+	f.size = f.sub;
+	return NULL;
+}
+
+#define ARITH_CODE( cmd, f, s)\
 {\
-	e1->code( s);\
-	int e1_is_const = expr_is_const;\
-	emit_push( ACC, s);\
-	e2->code( s);\
+	switch ( f.step++)\
+	{\
+	case 0:\
+		return e1;\
+	case 1:\
+		f.is_const = expr_is_const;\
+		emit_push( ACC, s);\
+		return e2;\
+	}\
+	int e1_is_const = f.is_const;\
 	int e2_is_const = expr_is_const;\
 	emit_move( T0, ACC, s);\
 	if ( e2_is_const)\
@@ -1628,42 +1857,46 @@ int let_class::get_temp_size() {
 	emit_##cmd( T0, T1, T0, s);\
 	emit_store_int( T0, ACC, s);\
 	expr_is_const = 0;\
+	return NULL;\
 }
 
-void plus_class::code(ostream &s) {
-	ARITH_CODE( add, s);
+Expression plus_class::code_step( code_frame_type &f, ostream &s) {
+	ARITH_CODE( add, f, s);
 }
 
-int plus_class::get_temp_size() {
-	return max( e1->get_temp_size(), e2->get_temp_size() + 1);
+Expression plus_class::temp_size_step( temp_frame_type &f) {
+	return binary_temp_size( f, e1, e2);
 }
 
-void sub_class::code(ostream &s) {
-	ARITH_CODE( sub, s);
+Expression sub_class::code_step( code_frame_type &f, ostream &s) {
+	ARITH_CODE( sub, f, s);
 }
 
-int sub_class::get_temp_size() {
-	return max( e1->get_temp_size(), e2->get_temp_size() + 1);
+Expression sub_class::temp_size_step( temp_frame_type &f) {
+	return binary_temp_size( f, e1, e2);
 }
 
-void mul_class::code(ostream &s) {
-	ARITH_CODE( mul, s);
+Expression mul_class::code_step( code_frame_type &f, ostream &s) {
+	ARITH_CODE( mul, f, s);
 }
 
-int mul_class::get_temp_size() {
-	return max( e1->get_temp_size(), e2->get_temp_size() + 1);
+Expression mul_class::temp_size_step( temp_frame_type &f) {
+	return binary_temp_size( f, e1, e2);
 }
 
-void divide_class::code(ostream &s) {
-	ARITH_CODE( div, s);
+Expression divide_class::code_step( code_frame_type &f, ostream &s) {
+	ARITH_CODE( div, f, s);
 }
 
-int divide_class::get_temp_size() {
-	return max( e1->get_temp_size(), e2->get_temp_size() + 1);
+Expression divide_class::temp_size_step( temp_frame_type &f) {
+	return binary_temp_size( f, e1, e2);
 }
 
-void neg_class::code(ostream &s) {
-	e1->code( s);
+Expression neg_class::code_step( code_frame_type &f, ostream &s) {
+	if ( f.step++ == 0)
+	{
+		return e1;
+	}
 	if ( expr_is_const)
 	{
 		emit_push( ACC, s);
@@ -1679,17 +1912,23 @@ void neg_class::code(ostream &s) {
 	}
 	emit_neg( T0, T0, s);
 	emit_store_int( T0, ACC, s);
+	return NULL;
 }
 
-int neg_class::get_temp_size() {
-	return e1->get_temp_size();
+Expression neg_class::temp_size_step( temp_frame_type &f) {
+	return unary_temp_size( f, e1);
 }
 
-void lt_class::code(ostream &s) {
-	e1->code( s);
-	emit_push( S1, s);
-	emit_fetch_int( S1, ACC, s);
-	e2->code( s);
+Expression lt_class::code_step( code_frame_type &f, ostream &s) {
+	switch ( f.step++)
+	{
+	case 0:
+		return e1;
+	case 1:
+		emit_push( S1, s);
+		emit_fetch_int( S1, ACC, s);
+		return e2;
+	}
 	emit_fetch_int( T0, ACC, s);
 
 	int end_label = new_label();
@@ -1698,16 +1937,22 @@ void lt_class::code(ostream &s) {
 	emit_load_bool( ACC, falsebool, s);
 	emit_label_def( end_label, s);
 	emit_pop( S1, s);
+	return NULL;
 }
 
-int lt_class::get_temp_size() {
-	return max( e1->get_temp_size(), e2->get_temp_size() + 1);
+Expression lt_class::temp_size_step( temp_frame_type &f) {
+	return binary_temp_size( f, e1, e2);
 }
 
-void eq_class::code(ostream &s) {
-	e1->code( s);
-	emit_push( ACC, s);
-	e2->code( s);
+Expression eq_class::code_step( code_frame_type &f, ostream &s) {
+	switch ( f.step++)
+	{
+	case 0:
+		return e1;
+	case 1:
+		emit_push( ACC, s);
+		return e2;
+	}
 	emit_pop( T2, s);
 
 	emit_move( T1, ACC, s);
@@ -1754,17 +1999,23 @@ void eq_class::code(ostream &s) {
 
 	emit_label_def( end_branch, s);
 	*/
+	return NULL;
 }
 
-int eq_class::get_temp_size() {
-	return max( e1->get_temp_size(), e2->get_temp_size() + 1);
+Expression eq_class::temp_size_step( temp_frame_type &f) {
+	return binary_temp_size( f, e1, e2);
 }
 
-void leq_class::code(ostream &s) {
-	e1->code( s);
-	emit_push( S1, s);
-	emit_fetch_int( S1, ACC, s);
-	e2->code( s);
+Expression leq_class::code_step( code_frame_type &f, ostream &s) {
+	switch ( f.step++)
+	{
+	case 0:
+		return e1;
+	case 1:
+		emit_push( S1, s);
+		emit_fetch_int( S1, ACC, s);
+		return e2;
+	}
 	emit_fetch_int( T0, ACC, s);
 
 	int end_label = new_label();
@@ -1773,56 +2024,67 @@ void leq_class::code(ostream &s) {
 	emit_load_bool( ACC, truebool, s);
 	emit_label_def( end_label, s);
 	emit_pop( S1, s);
+	return NULL;
 }
 
-int leq_class::get_temp_size() {
-	return max( e1->get_temp_size(), e2->get_temp_size() + 1);
+Expression leq_class::temp_size_step( temp_frame_type &f) {
+	return binary_temp_size( f, e1, e2);
 }
 
-void comp_class::code(ostream &s) {
-	e1->code( s);
+Expression comp_class::code_step( code_frame_type &f, ostream &s) {
+	if ( f.step++ == 0)
+	{
+		return e1;
+	}
 	emit_load_bool( T0, falsebool, s);
 	emit_xor( ACC, T0, ACC, s);
 	emit_load_bool( T0, truebool, s);
 	emit_xor( ACC, T0, ACC, s);
+	return NULL;
 }
 
-int comp_class::get_temp_size() {
-	return e1->get_temp_size();
+Expression comp_class::temp_size_step( temp_frame_type &f) {
+	return unary_temp_size( f, e1);
 }
 
-void int_const_class::code(ostream& s)
+Expression int_const_class::code_step( code_frame_type &f, ostream &s)
 {
   //
   // Need to be sure we have an IntEntry *, not an arbitrary Symbol
   //
   emit_load_int(ACC,inttable.lookup_string(token->get_string()),s);
   expr_is_const = 1;
+  return NULL;
 }
 
-int int_const_class::get_temp_size() {
-	return 0;
+Expression int_const_class::temp_size_step( temp_frame_type &f) {
+	f.size = 0;
+	return NULL;
 }
 
-void string_const_class::code(ostream& s)
+Expression string_const_class::code_step( code_frame_type &f, ostream &s)
 {
   emit_load_string(ACC,stringtable.lookup_string(token->get_string()),s);
+  return NULL;
 }
 
-int string_const_class::get_temp_size() {
-	return 0;
+Expression string_const_class::temp_size_step( temp_frame_type &f) {
+	f.size = 0;
+	return NULL;
 }
 
-void bool_const_class::code(ostream& s)
+Expression bool_const_class::code_step( code_frame_type &f, ostream &s)
 {
   emit_load_bool(ACC,BoolConst(val),s);
+  return NULL;
 }
 
-int bool_const_class::get_temp_size() {
-	return 0;
+Expression bool_const_class::temp_size_step( temp_frame_type &f) {
+	f.size = 0;
+	return NULL;
 }
 
-void new__class::code(ostream &s) {
+Expression new__class::code_step( code_frame_type &f, ostream &s) {
 	if ( type_name == SELF_TYPE)
 	{
 		// Calcu address
@@ -1856,14 +2118,19 @@ void new__class::code(ostream &s) {
 			emit_load_bool( ACC, falsebool, s);
 		}
 	}
+	return NULL;
 }
 
-int new__class::get_temp_size() {
-	return 1;
+Expression new__class::temp_size_step( temp_frame_type &f) {
+	f.size = 1;
+	return NULL;
 }
 
-void isvoid_class::code(ostream &s) {
-	e1->code( s);
+Expression isvoid_class::code_step( code_frame_type &f, ostream &s) {
+	if ( f.step++ == 0)
+	{
+		return e1;
+	}
 
 	int end_label = new_label();
 	emit_load_bool( T0, falsebool, s);
@@ -1897,21 +2164,24 @@ void isvoid_class::code(ostream &s) {
 	emit_load_bool( ACC, BoolConst(0), s);
 	emit_label_def( end_label, s);
 	*/
+	return NULL;
 }
 
-int isvoid_class::get_temp_size() {
-	return e1->get_temp_size();
+Expression isvoid_class::temp_size_step( temp_frame_type &f) {
+	return unary_temp_size( f, e1);
 }
 
-void no_expr_class::code(ostream &s) {
+Expression no_expr_class::code_step( code_frame_type &f, ostream &s) {
 	emit_load_imm( ACC, 0, s);
+	return NULL;
 }
 
-int no_expr_class::get_temp_size() {
-	return 0;
+Expression no_expr_class::temp_size_step( temp_frame_type &f) {
+	f.size = 0;
+	return NULL;
 }
 
-void object_class::code(ostream &s) {
+Expression object_class::code_step( code_frame_type &f, ostream &s) {
 	if ( cgen_debug)
 		cout << "Looking for var " << name << endl;
 
@@ -1927,9 +2197,11 @@ void object_class::code(ostream &s) {
 	{
 		emit_move( ACC, SELF, s);
 	}
+	return NULL;
 }
 
-int object_class::get_temp_size() {
-	return 0;
+Expression object_class::temp_size_step( temp_frame_type &f) {
+	f.size = 0;
+	return NULL;
 }
 
@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <stdio.h>
+#include <vector>
 #include "emit.h"
 #include "cool-tree.h"
 #include "symtab.h"
@@ -116,6 +117,42 @@ public:
    int lookup_method_offset( Symbol name) { return ( int) method_offset_table.lookup( name);}
 };
 
+// An expression part way through Expression_class::code(): the state
+// its code() kept in local variables between coding subexpressions.
+struct case_range_type
+{
+	int x, y;	// class tags the branch covers
+	int c;		// the branch
+};
+
+struct code_frame_type
+{
+	Expression expr;
+	int step;
+	int i;
+	int label;
+	int end_label;
+	int temp;
+	int is_const;
+	std::vector< case_range_type> cases;
+
+	code_frame_type( Expression e) : expr( e), step( 0), i( 0) {}
+};
+
+// An expression part way through Expression_class::get_temp_size():
+// `sub' is the size of the subexpression just done, `size' the largest
+// so far.
+struct temp_frame_type
+{
+	Expression expr;
+	int step;
+	int i;
+	int sub;
+	int size;
+
+	temp_frame_type( Expression e) : expr( e), step( 0), i( 0), sub( 0), size( 0) {}
+};
+
 class BoolConst
 {
  private:
@@ -9,7 +9,7 @@
 //////////////////////////////////////////////////////////
 
 
-#include "tree.h"
+#include "tree-node.h"
 #include "cool-tree.handcode.h"
 
 
@@ -5,7 +5,7 @@
 #define COOL_TREE_HANDCODE_H
 
 #include <iostream>
-#include "tree.h"
+#include "tree-node.h"
 #include "cool.h"
 #include "stringtab.h"
 #define yylineno curr_lineno;
@@ -44,28 +44,64 @@ typedef Expressions_class *Expressions;
 typedef list_node<Case> Cases_class;
 typedef Cases_class *Cases;
 
+struct code_frame_type;
+struct temp_frame_type;
+
+// coolc, the single-process compiler driver (coolc.cc), links PA4's
+// semant.cc with this code generator, so it is built with COOLC_DRIVER
+// defined and the tree then also carries what semant.cc declares, from
+// the same header PA4's cool-tree.h uses.  cgen on its own gets none
+// of it.
+#ifdef COOLC_DRIVER
+
+#include "../PA4/semant-tree.h"
+
+#define no_expr_EXTRAS				\
+no_expr_SEMANT_EXTRAS
+
+#else
+
+#define Program_SEMANT_EXTRAS
+#define program_SEMANT_EXTRAS
+#define Class__SEMANT_EXTRAS
+#define class__SEMANT_EXTRAS
+#define Feature_SEMANT_EXTRAS
+#define Feature_SHARED_SEMANT_EXTRAS
+#define Formal_SEMANT_EXTRAS
+#define formal_SEMANT_EXTRAS
+#define Case_SEMANT_EXTRAS
+#define branch_SEMANT_EXTRAS
+#define Expression_SEMANT_EXTRAS
+#define Expression_SHARED_SEMANT_EXTRAS
+
+#endif
+
 #define Program_EXTRAS                          \
 virtual void cgen(ostream&) = 0;		\
-virtual void dump_with_types(ostream&, int) = 0;
+virtual void dump_with_types(ostream&, int) = 0; \
+Program_SEMANT_EXTRAS
 
 
 
 #define program_EXTRAS                          \
 void cgen(ostream&);     			\
-void dump_with_types(ostream&, int);
+void dump_with_types(ostream&, int);		\
+program_SEMANT_EXTRAS
 
 #define Class__EXTRAS                   \
 virtual Symbol get_name() = 0;  	\
 virtual Symbol get_parent() = 0;    	\
 virtual Symbol get_filename() = 0;      \
-virtual void dump_with_types(ostream&,int) = 0;
+virtual void dump_with_types(ostream&,int) = 0; \
+Class__SEMANT_EXTRAS
 
 
 #define class__EXTRAS                                  \
 Symbol get_name()   { return name; }		       \
 Symbol get_parent() { return parent; }     	       \
 Symbol get_filename() { return filename; }             \
-void dump_with_types(ostream&,int);
+void dump_with_types(ostream&,int);			       \
+class__SEMANT_EXTRAS
 
 
 #define Feature_EXTRAS                                        \
@@ -74,53 +110,63 @@ virtual void code( ostream &s) = 0; 			      \
 virtual int is_method() const = 0; 			      \
 virtual int get_temp_size() = 0; 			      \
 virtual Symbol get_type() const = 0;			      \
-virtual Symbol get_name() const = 0;
+virtual Symbol get_name() const = 0;			      \
+Feature_SEMANT_EXTRAS
 
 
 #define Feature_SHARED_EXTRAS                                       \
 void dump_with_types(ostream&,int); 				    \
 void code( ostream &s); 					    \
-int get_temp_size();
+int get_temp_size();						    \
+Feature_SHARED_SEMANT_EXTRAS
 
 
 #define Formal_EXTRAS                              \
 virtual void dump_with_types(ostream&,int) = 0;    \
-virtual Symbol get_name() = 0;
+virtual Symbol get_name() = 0;			   \
+Formal_SEMANT_EXTRAS
 
 
 #define formal_EXTRAS                           \
 void dump_with_types(ostream&,int); 		\
-Symbol get_name() { return name;}
+Symbol get_name() { return name;}		\
+formal_SEMANT_EXTRAS
 
 
 #define Case_EXTRAS                             \
 virtual void dump_with_types(ostream& ,int) = 0;\
 virtual Expression get_expr() = 0; 		\
 virtual Symbol get_name() = 0; 			\
-virtual Symbol get_type_decl() = 0;
+virtual Symbol get_type_decl() = 0;		\
+Case_SEMANT_EXTRAS
 
 
 #define branch_EXTRAS                                   \
 void dump_with_types(ostream& ,int); 			\
 Expression get_expr() { return expr;} 			\
 Symbol get_name() { return name;} 			\
-Symbol get_type_decl() { return type_decl;}
+Symbol get_type_decl() { return type_decl;}		\
+branch_SEMANT_EXTRAS
 
 
 #define Expression_EXTRAS                    \
 Symbol type;                                 \
 Symbol get_type() { return type; }           \
 Expression set_type(Symbol s) { type = s; return this; } \
-virtual void code(ostream&) = 0; \
+void code(ostream&); \
+virtual Expression code_step(code_frame_type&, ostream&) = 0; \
 virtual void dump_with_types(ostream&,int) = 0;  \
 void dump_type(ostream&, int);               \
 Expression_class() { type = (Symbol) NULL; } \
-virtual int get_temp_size() = 0;
+int get_temp_size();                         \
+virtual Expression temp_size_step(temp_frame_type&) = 0; \
+Expression_SEMANT_EXTRAS
 
 #define Expression_SHARED_EXTRAS           \
-void code(ostream&); 			   \
+Expression code_step(code_frame_type&, ostream&); \
 void dump_with_types(ostream&,int); 	   \
-int get_temp_size();
+Expression temp_size_step(temp_frame_type&); \
+Expression_SHARED_SEMANT_EXTRAS
 
 
 #endif
@@ -0,0 +1,15 @@
+//
+// PA4's semantic checker, built against this directory's cool-tree.h
+// for coolc (see coolc.cc).  cool-tree.h has to come first: semant.cc
+// includes semant.h from PA4, whose own cool-tree.h is then skipped.
+// With COOLC_DRIVER defined, this cool-tree.h declares everything
+// semant.cc defines.
+//
+// Both phases keep a global var_table of their own; semant's is
+// renamed so the two can be linked together.
+//
+
+#include "cool-tree.h"
+
+#define var_table semant_var_table
+#include "../PA4/semant.cc"
@@ -0,0 +1,255 @@
+/*
+ *  coolc: the whole compiler in one process.
+ *
+ *  The course coolc runs lexer | parser | semant | cgen, and each stage
+ *  prints the tree for the next one to parse back.  This driver lexes
+ *  and parses the files with cool_yyparse(), then runs semant() and
+ *  cgen() on the same tree: the types semant sets on each expression
+ *  are read by cgen where they are, and nothing is printed in between.
+ *
+ *    coolc [flags] file.cl ...
+ *
+ *  The flags are those of the phases (handle_flags.cc), -o included.
+ *  Errors stop the compile after the phase that found them, with the
+ *  messages the phases print.  COOLC_TIMES=1 reports the time spent in
+ *  each phase on stderr.
+ *
+ *  With COOLC_STREAM=1, each class goes into semant's class table as
+ *  soon as it is parsed (parse_class_hook in cool.y), so the inheritance
+ *  graph is built while the parser carries on; the type checking still
+ *  waits for the last class.  The parse time then
+ *  includes building the class table.
+ *
+ *  With COOL_PARSE_SHARE=1, the parser hands out one node for all the
+ *  copies of an expression that means the same everywhere (see cool.y),
+ *  and semant checks it once.  An error in such an expression is then
+ *  reported once, at its first occurrence, even when that was in an
+ *  earlier file.  share-bench.sh times the difference, and
+ *  share-verify.sh checks that the code is the same.
+ *
+ *  With COOL_SEMANT_STATS=file (or - for stderr), semant writes a JSON
+ *  report as the process exits: the time each class took to install
+ *  and to check, and, in a build with -DSEMANT_STATS, counts of table
+ *  lookups and scopes, method searches, subclass tests and checked
+ *  expressions.
+ *
+ *  The tree can be handed between phases as a binary AST file
+ *  (ast-binary.h), as the course's phases hand it on as text:
+ *
+ *    COOLC_STOP=parse|semant  stops after that phase
+ *    COOLC_AST_OUT=file       writes the tree to file after the last
+ *                             phase run, typed if that was semant
+ *    COOLC_AST_IN=file        reads the tree from file instead of
+ *                             parsing; semant is skipped if it is typed
+ *
+ *  so `COOLC_STOP=semant COOLC_AST_OUT=a.ast coolc a.cl` and then
+ *  `COOLC_AST_IN=a.ast coolc -o a.s` compile in two steps.  The output
+ *  is named after the AST file when there is no source file.
+ *  COOLC_STREAM is ignored when the tree is read.
+ *
+ *  Every file of the driver is compiled with COOLC_DRIVER defined, so
+ *  that the tree has semant's members as well as cgen's (see
+ *  cool-tree.handcode.h).  Build it here, after make has generated the
+ *  lexer in PA2 and the parser in PA3:
+ *
+ *    g++ -g -O2 -DCOOLC_DRIVER -I. -I../PA4 -I../../include/PA5 -I../../include/PA4 \
+ *        -include tree-node.h \
+ *        coolc.cc coolc-semant.cc cgen.cc cgen_supp.cc \
+ *        ../PA2/cool-lex.cc ../PA3/cool-parse.cc \
+ *        ../../src/PA5/utilities.cc ../../src/PA5/stringtab.cc \
+ *        ../../src/PA5/dumptype.cc ../../src/PA5/tree.cc \
+ *        ../../src/PA5/cool-tree.cc ../../src/PA5/handle_flags.cc \
+ *        -lpthread -o coolc
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <fstream>
+
+#include "cool-tree.h"
+#include "../PA4/ast-binary.h"
+
+extern int cool_yyparse();
+void lex_restart();
+extern Program ast_root;
+extern int omerrs;
+extern int curr_lineno;
+extern char *out_filename;
+extern void ( *parse_class_hook)( Class_);
+void handle_flags( int argc, char *argv[]);
+void semant_stream_begin();
+void semant_stream_class( Class_ c);
+
+FILE *fin;
+char *curr_filename = ( char *) "<stdin>";
+
+static int show_times;
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void phase_done( const char *phase, double &start)
+{
+	double stop = now();
+	if ( show_times)
+	{
+		fprintf( stderr, "coolc: %-7s %8.3fs\n", phase, stop - start);
+	}
+	start = stop;
+}
+
+/* Whether COOLC_STOP says to stop after phase. */
+static bool stop_after( const char *phase)
+{
+	char *stop = getenv( "COOLC_STOP");
+	return stop && !strcmp( stop, phase);
+}
+
+/* Writes root to COOLC_AST_OUT, if it is set; false if that fails. */
+static bool write_ast( Program root, double &start)
+{
+	char *path = getenv( "COOLC_AST_OUT");
+	if ( !path)
+	{
+		return true;
+	}
+	if ( !ast_binary_write( root, path))
+	{
+		perror( path);
+		return false;
+	}
+	phase_done( "write", start);
+	return true;
+}
+
+/*
+ * Parses every file into one program, as the course parser does with
+ * the tokens of several files.  Each cool_yyparse() reads one file.  A
+ * parse can stop short of the end of its file, so the lexer is told to
+ * start afresh before the file is closed and the next one opened.
+ */
+static Program parse_files( int count, char **names)
+{
+	Classes classes = nil_Classes();
+
+	for ( int i = 0; i < count; ++i)
+	{
+		fin = fopen( names[i], "r");
+		if ( fin == NULL)
+		{
+			cerr << "Could not open input file " << names[i] << endl;
+			exit( 1);
+		}
+
+		curr_filename = names[i];
+		curr_lineno = 1;
+		ast_root = NULL;
+		cool_yyparse();
+		lex_restart();
+		fclose( fin);
+		fin = NULL;
+		if ( ast_root)
+		{
+			program_class *parsed = ( program_class *) ast_root;
+			classes = append_Classes( classes, parsed->classes);
+		}
+	}
+
+	if ( omerrs != 0)
+	{
+		cerr << "Compilation halted due to lex and parse errors\n";
+		exit( 1);
+	}
+	return program( classes);
+}
+
+int main( int argc, char **argv)
+{
+	char *times = getenv( "COOLC_TIMES");
+	show_times = times && atoi( times) > 0;
+
+	handle_flags( argc, argv);
+	char *ast_in = getenv( "COOLC_AST_IN");
+	if ( optind >= argc && !ast_in)
+	{
+		cerr << "usage: coolc [flags] file.cl ..." << endl;
+		return 1;
+	}
+
+	// Named after the first file unless -o says otherwise, as mycoolc does.
+	if ( !out_filename)
+	{
+		char *name = optind < argc ? argv[optind] : ast_in;
+		char *dot = strrchr( name, '.');
+		size_t stem = dot ? ( size_t) ( dot - name) : strlen( name);
+		out_filename = new char[stem + 3];
+		memcpy( out_filename, name, stem);
+		strcpy( out_filename + stem, ".s");
+	}
+
+	char *stream = getenv( "COOLC_STREAM");
+	if ( stream && atoi( stream) > 0 && !ast_in)
+	{
+		semant_stream_begin();
+		parse_class_hook = semant_stream_class;
+	}
+
+	double start = now();
+	Program root;
+	bool typed = false;
+	if ( ast_in)
+	{
+		root = ast_binary_read( ast_in, &typed);
+		if ( !root)
+		{
+			cerr << "Could not read AST file " << ast_in << endl;
+			return 1;
+		}
+		phase_done( "read", start);
+	}
+	else
+	{
+		root = parse_files( argc - optind, argv + optind);
+		phase_done( "parse", start);
+		if ( stop_after( "parse"))
+		{
+			return write_ast( root, start) ? 0 : 1;
+		}
+	}
+
+	// semant() exits if the program has errors.
+	if ( !typed)
+	{
+		root->semant();
+		phase_done( "semant", start);
+	}
+	if ( stop_after( "semant"))
+	{
+		return write_ast( root, start) ? 0 : 1;
+	}
+
+	// The output file is only created once the program is known to be good.
+	std::ofstream s( out_filename);
+	if ( !s)
+	{
+		cerr << "Cannot open output file " << out_filename << endl;
+		return 1;
+	}
+	root->cgen( s);
+	phase_done( "cgen", start);
+	if ( !write_ast( root, start))
+	{
+		return 1;
+	}
+
+	// The parser made the tree in tree_arena (see tree-node.h); nothing needs it now.
+	tree_arena::release();
+	return 0;
+}
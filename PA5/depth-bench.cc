@@ -0,0 +1,139 @@
+/*
+ *  Nesting depth benchmark.
+ *
+ *  Builds one method body nested to a given depth and times semant's
+ *  type check, the temp count and the code generation over it, for
+ *  doubling depths.  All three walk the tree with a stack of their own,
+ *  so the time per level should stay flat as the depth grows past what
+ *  the C stack would hold.
+ *
+ *    depth-bench [shape] [max-depth]
+ *
+ *  shape  plus  0 + 1 + 1 + ... (left-nested, the default)
+ *         let   let x : Int <- 1 in let x : Int <- 1 in ... x
+ *         if    if true then 0 else if true then 0 else ... 0 fi fi
+ *
+ *  The trees are built directly: bison's stack stops the parser long
+ *  before these depths for the right-nested shapes.  Each depth runs in
+ *  a child process, since semant and cgen keep global state.
+ *
+ *  Build it like coolc (see coolc.cc), with depth-bench.cc in place of
+ *  coolc.cc:
+ *
+ *    g++ -g -O2 -DCOOLC_DRIVER -I. -I../PA4 -I../../include/PA5 -I../../include/PA4 \
+ *        -include tree-node.h \
+ *        depth-bench.cc coolc-semant.cc cgen.cc cgen_supp.cc \
+ *        ../PA2/cool-lex.cc ../PA3/cool-parse.cc \
+ *        ../../src/PA5/utilities.cc ../../src/PA5/stringtab.cc \
+ *        ../../src/PA5/dumptype.cc ../../src/PA5/tree.cc \
+ *        ../../src/PA5/cool-tree.cc ../../src/PA5/handle_flags.cc \
+ *        -lpthread -o depth-bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <fstream>
+
+#include "cool-tree.h"
+
+FILE *fin;
+char *curr_filename = ( char *) "<depth-bench>";
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static Expression nested( const char *shape, int depth)
+{
+	Symbol x = idtable.add_string( ( char *) "x");
+	Symbol Int = idtable.add_string( ( char *) "Int");
+	Symbol zero = inttable.add_string( ( char *) "0");
+	Symbol one = inttable.add_string( ( char *) "1");
+
+	if ( !strcmp( shape, "let"))
+	{
+		Expression e = object( x);
+		for ( int i = 0; i < depth; ++i)
+		{
+			e = let( x, Int, int_const( one), e);
+		}
+		return e;
+	}
+	if ( !strcmp( shape, "if"))
+	{
+		Expression e = int_const( zero);
+		for ( int i = 0; i < depth; ++i)
+		{
+			e = cond( bool_const( true), int_const( zero), e);
+		}
+		return e;
+	}
+
+	Expression e = int_const( zero);
+	for ( int i = 0; i < depth; ++i)
+	{
+		e = plus( e, int_const( one));
+	}
+	return e;
+}
+
+static void run( const char *shape, int depth)
+{
+	Expression body = nested( shape, depth);
+	Feature main_method = method( idtable.add_string( ( char *) "main"), nil_Formals(),
+			idtable.add_string( ( char *) "Int"), body);
+	Program program = ::program( single_Classes( class_( idtable.add_string( ( char *) "Main"),
+			idtable.add_string( ( char *) "Object"), single_Features( main_method),
+			stringtable.add_string( curr_filename))));
+
+	double start = now();
+	program->semant();
+	double semant = now() - start;
+
+	start = now();
+	int temps = body->get_temp_size();
+	double temp_size = now() - start;
+
+	std::ofstream out( "/dev/null");
+	start = now();
+	program->cgen( out);
+	double cgen = now() - start;
+
+	printf( "%10d %12.1f %12.1f %12.1f %8d\n", depth, semant * 1e9 / depth,
+			temp_size * 1e9 / depth, cgen * 1e9 / depth, temps);
+}
+
+int main( int argc, char **argv)
+{
+	const char *shape = argc > 1 ? argv[1] : "plus";
+	int max = argc > 2 ? atoi( argv[2]) : 1 << 21;
+
+	printf( "%10s %12s %12s %12s %8s\n", "depth", "semant ns/el", "temps ns/el",
+			"cgen ns/el", "temps");
+	fflush( stdout);
+	for ( int depth = 1024; depth <= max; depth *= 2)
+	{
+		pid_t child = fork();
+		if ( child == 0)
+		{
+			run( shape, depth);
+			exit( 0);
+		}
+
+		int status;
+		if ( child < 0 || waitpid( child, &status, 0) < 0 ||
+				!WIFEXITED( status) || WEXITSTATUS( status) != 0)
+		{
+			fprintf( stderr, "depth-bench: depth %d failed\n", depth);
+			return 1;
+		}
+	}
+	return 0;
+}
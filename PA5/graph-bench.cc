@@ -0,0 +1,150 @@
+/*
+ *  Inheritance graph benchmark.
+ *
+ *  Builds a program of many classes in one of three shapes and type
+ *  checks it, timing semant as a whole: building the graph, the depths
+ *  (fill_depth() and find_set()), and the walk that checks each class
+ *  (walk_down()).
+ *
+ *    chain    C0 inherits Object and each Ci inherits Ci-1
+ *    star     every Ci inherits Object
+ *    random   each Ci inherits a Cj, j < i, picked at random
+ *
+ *    graph-bench chain|star|random [classes]
+ *
+ *  A chain of the default 200000 classes is far deeper than the C
+ *  stack would allow if any of the three recursed once per level.
+ *
+ *  Build it like coolc (see coolc.cc), with graph-bench.cc in place of
+ *  coolc.cc:
+ *
+ *    g++ -g -O2 -DCOOLC_DRIVER -I. -I../PA4 -I../../include/PA5 -I../../include/PA4 \
+ *        -include tree-node.h \
+ *        graph-bench.cc coolc-semant.cc cgen.cc cgen_supp.cc \
+ *        ../PA2/cool-lex.cc ../PA3/cool-parse.cc \
+ *        ../../src/PA5/utilities.cc ../../src/PA5/stringtab.cc \
+ *        ../../src/PA5/dumptype.cc ../../src/PA5/tree.cc \
+ *        ../../src/PA5/cool-tree.cc ../../src/PA5/handle_flags.cc \
+ *        -lpthread -o graph-bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <vector>
+
+#include "cool-tree.h"
+#include "../PA4/semant.h"
+
+FILE *fin;
+char *curr_filename = ( char *) "<graph-bench>";
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static Symbol id( const char *s)
+{
+	return idtable.add_string( ( char *) s);
+}
+
+/*
+ * Made directly, as the string tables search a list; <prefix><i> is
+ * names[i], numbered from first.
+ */
+static std::vector< Symbol> bench_names( const char *prefix, int count, int first)
+{
+	std::vector< Symbol> names;
+	for ( int c = 0; c < count; ++c)
+	{
+		char name[16];
+		int len = sprintf( name, "%s%d", prefix, c);
+		names.push_back( new IdEntry( name, len, first + c));
+	}
+	return names;
+}
+
+/* The father each class is given, -1 for Object. */
+static std::vector< int> bench_fathers( const char *shape, int classes)
+{
+	std::vector< int> fathers( classes, -1);
+	unsigned seed = 12345;
+	for ( int c = 1; c < classes; ++c)
+	{
+		if ( strcmp( shape, "chain") == 0)
+		{
+			fathers[c] = c - 1;
+		}
+		else if ( strcmp( shape, "random") == 0)
+		{
+			seed = seed * 1103515245u + 12345u;
+			fathers[c] = ( seed >> 8) % c;
+		}
+	}
+	return fathers;
+}
+
+/*
+ *  class C<i> inherits C<father> {
+ *    a<i> : Int;
+ *    m() : Object { if true then self else a<i> fi };
+ *  };
+ */
+static Program bench_program( const std::vector< Symbol> &names,
+		const std::vector< Symbol> &attrs, const std::vector< int> &fathers)
+{
+	Symbol filename = stringtable.add_string( curr_filename);
+	Symbol Object = id( "Object");
+	Symbol Int = id( "Int");
+	Symbol m = id( "m");
+	Classes list = single_Classes( class_( id( "Main"), Object,
+				single_Features( method( id( "main"), nil_Formals(), Object,
+						object( id( "self")))), filename));
+	for ( size_t c = 0; c < names.size(); ++c)
+	{
+		Expression body = cond( bool_const( 1), object( id( "self")),
+				object( attrs[c]));
+		Features features = append_Features(
+				single_Features( attr( attrs[c], Int, no_expr())),
+				single_Features( method( m, nil_Formals(), Object, body)));
+		Symbol parent = fathers[c] < 0 ? Object : names[fathers[c]];
+		list = append_Classes( list, single_Classes( class_( names[c], parent,
+						features, filename)));
+	}
+	return program( list);
+}
+
+int main( int argc, char **argv)
+{
+	const char *shape = argc > 1 ? argv[1] : "chain";
+	int classes = argc > 2 ? atoi( argv[2]) : 200000;
+	if ( strcmp( shape, "chain") && strcmp( shape, "star") && strcmp( shape, "random"))
+	{
+		fprintf( stderr, "usage: graph-bench chain|star|random [classes]\n");
+		return 1;
+	}
+
+	std::vector< Symbol> names = bench_names( "C", classes, 0);
+	std::vector< Symbol> attrs = bench_names( "a", classes, classes);
+	Program p = bench_program( names, attrs, bench_fathers( shape, classes));
+
+	double start = now();
+	p->semant();
+	double secs = now() - start;
+
+	int deepest = 0;
+	for ( class_tree_node n = class_tree_node_type::all_node_head; n; n = n->all_node_next)
+	{
+		if ( n->depth > deepest)
+		{
+			deepest = n->depth;
+		}
+	}
+	printf( "%s, %d classes, deepest at %d: semant %.3fs, %.0f classes/s\n",
+			shape, classes, deepest, secs, secs > 0 ? classes / secs : 0.0);
+	return 0;
+}
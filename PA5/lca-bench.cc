@@ -0,0 +1,204 @@
+/*
+ *  Inheritance query benchmark.
+ *
+ *  Builds a program of many classes in one of two shapes, type checks
+ *  it, and then times subtype tests and least common ancestors between
+ *  random pairs of its classes, as semant answers them (the preorder
+ *  intervals and the sparse table of class_tree_node_type) and by
+ *  climbing the father chains, as it used to.  The two must agree.
+ *
+ *    deep   C0 inherits Object and each Ci inherits Ci-1
+ *    wide   every Ci inherits Object
+ *
+ *    lca-bench deep|wide [classes] [queries]
+ *
+ *  Each class has a method joining self with another class in an if,
+ *  so semant itself asks for an LCA per class.  Climbing takes time in
+ *  the depth of the classes, so the deep shape is where it shows.
+ *
+ *  Build it like coolc (see coolc.cc), with lca-bench.cc in place of
+ *  coolc.cc:
+ *
+ *    g++ -g -O2 -DCOOLC_DRIVER -I. -I../PA4 -I../../include/PA5 -I../../include/PA4 \
+ *        -include tree-node.h \
+ *        lca-bench.cc coolc-semant.cc cgen.cc cgen_supp.cc \
+ *        ../PA2/cool-lex.cc ../PA3/cool-parse.cc \
+ *        ../../src/PA5/utilities.cc ../../src/PA5/stringtab.cc \
+ *        ../../src/PA5/dumptype.cc ../../src/PA5/tree.cc \
+ *        ../../src/PA5/cool-tree.cc ../../src/PA5/handle_flags.cc \
+ *        -lpthread -o lca-bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <vector>
+
+#include "cool-tree.h"
+#include "../PA4/semant.h"
+
+FILE *fin;
+char *curr_filename = ( char *) "<lca-bench>";
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static Symbol id( const char *s)
+{
+	return idtable.add_string( ( char *) s);
+}
+
+/*
+ * Made directly, as the string tables search a list; C<i> is
+ * names[i].
+ */
+static std::vector< Symbol> bench_names( int classes)
+{
+	std::vector< Symbol> names;
+	for ( int c = 0; c < classes; ++c)
+	{
+		char name[16];
+		int len = sprintf( name, "C%d", c);
+		names.push_back( new IdEntry( name, len, c));
+	}
+	return names;
+}
+
+/*
+ *  class C<i> inherits C<i-1> {
+ *    m() : Object { if true then self else new C<i/2> fi };
+ *  };
+ */
+static Program bench_program( const std::vector< Symbol> &names, bool deep)
+{
+	Symbol filename = stringtable.add_string( curr_filename);
+	Symbol Object = id( "Object");
+	Symbol m = id( "m");
+	Classes list = single_Classes( class_( id( "Main"), Object,
+				single_Features( method( id( "main"), nil_Formals(), Object,
+						object( id( "self")))), filename));
+	for ( size_t c = 0; c < names.size(); ++c)
+	{
+		Expression body = cond( bool_const( 1), object( id( "self")),
+				new_( names[c / 2]));
+		Features features = single_Features( method( m, nil_Formals(), Object, body));
+		Symbol parent = deep && c > 0 ? names[c - 1] : Object;
+		list = append_Classes( list, single_Classes( class_( names[c], parent,
+						features, filename)));
+	}
+	return program( list);
+}
+
+/* What is_sub_class_of() and find_class_lca() did before. */
+static bool climb_sub_class( class_tree_node x, class_tree_node super)
+{
+	while ( x->depth > super->depth)
+	{
+		x = x->father;
+	}
+	return x == super;
+}
+
+static class_tree_node climb_lca( class_tree_node x, class_tree_node y)
+{
+	int depth = x->depth < y->depth ? x->depth : y->depth;
+	while ( x && x->depth != depth)
+	{
+		x = x->father;
+	}
+	while ( y && y->depth != depth)
+	{
+		y = y->father;
+	}
+	while ( x && y && x != y)
+	{
+		x = x->father;
+		y = y->father;
+	}
+	return x ? y : NULL;
+}
+
+int main( int argc, char **argv)
+{
+	bool deep = argc < 2 || strcmp( argv[1], "wide") != 0;
+	int classes = argc > 2 ? atoi( argv[2]) : 10000;
+	long queries = argc > 3 ? atol( argv[3]) : 1000000;
+
+	std::vector< Symbol> names = bench_names( classes);
+	Program p = bench_program( names, deep);
+
+	double start = now();
+	p->semant();
+	printf( "%s, %d classes: semant %.3fs\n", deep ? "deep" : "wide", classes,
+			now() - start);
+
+	std::vector< class_tree_node> nodes;
+	for ( class_tree_node n = class_tree_node_type::all_node_head; n; n = n->all_node_next)
+	{
+		if ( n->is_defined())
+		{
+			nodes.push_back( n);
+		}
+	}
+
+	std::vector< std::pair< class_tree_node, class_tree_node> > pairs;
+	unsigned seed = 12345;
+	for ( long q = 0; q < queries; ++q)
+	{
+		seed = seed * 1103515245u + 12345u;
+		class_tree_node x = nodes[( seed >> 8) % nodes.size()];
+		seed = seed * 1103515245u + 12345u;
+		class_tree_node y = nodes[( seed >> 8) % nodes.size()];
+		pairs.push_back( std::make_pair( x, y));
+	}
+
+	long subs[2] = { 0, 0 }, lcas[2] = { 0, 0 };
+	double secs[4];
+
+	start = now();
+	for ( long q = 0; q < queries; ++q)
+	{
+		subs[0] += pairs[q].first->is_sub_class_of( pairs[q].second);
+	}
+	secs[0] = now() - start;
+
+	start = now();
+	for ( long q = 0; q < queries; ++q)
+	{
+		subs[1] += climb_sub_class( pairs[q].first, pairs[q].second);
+	}
+	secs[1] = now() - start;
+
+	start = now();
+	for ( long q = 0; q < queries; ++q)
+	{
+		class_tree_node lca = find_class_lca( pairs[q].first, pairs[q].second);
+		lcas[0] += lca ? lca->depth + 1 : 0;
+	}
+	secs[2] = now() - start;
+
+	start = now();
+	for ( long q = 0; q < queries; ++q)
+	{
+		class_tree_node lca = climb_lca( pairs[q].first, pairs[q].second);
+		lcas[1] += lca ? lca->depth + 1 : 0;
+	}
+	secs[3] = now() - start;
+
+	printf( "subclass: %8.1f ns table, %10.1f ns climbing (%ld true)\n",
+			secs[0] * 1e9 / queries, secs[1] * 1e9 / queries, subs[0]);
+	printf( "lca:      %8.1f ns table, %10.1f ns climbing (%ld)\n",
+			secs[2] * 1e9 / queries, secs[3] * 1e9 / queries, lcas[0]);
+
+	if ( subs[0] != subs[1] || lcas[0] != lcas[1])
+	{
+		fprintf( stderr, "lca-bench: the tables and the climb disagree\n");
+		return 1;
+	}
+	return 0;
+}
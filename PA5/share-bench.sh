@@ -0,0 +1,62 @@
+#!/bin/sh
+#
+# Times coolc on generated code that repeats the same expressions over
+# and over, with and without hash-consing in the parser
+# (COOL_PARSE_SHARE).  COOLC_TIMES gives the time of each phase, and
+# COOL_PARSE_STATS how many of the expressions parsed were shared.
+#
+#   ./share-bench.sh [methods] [coolc]
+#
+# methods  methods to generate (default 20000), ten to a class, each a
+#          block of the same dozen statements with a few constants
+#          that vary
+# coolc    compiler to run (default ./coolc)
+#
+# Only semant should get much faster: cgen still emits the code of
+# every occurrence.  The code is the same (share-verify.sh checks
+# that), but an error in a repeated expression is only reported at its
+# first occurrence, and not at all if that was in an earlier file.
+
+methods=${1:-20000}
+coolc=${2:-./coolc}
+input=${TMPDIR:-/tmp}/share-bench.$$.cl
+output=${TMPDIR:-/tmp}/share-bench.$$.s
+stats=${TMPDIR:-/tmp}/share-bench.$$.stats
+
+trap 'rm -f "$input" "$output" "$stats"' EXIT INT TERM
+
+awk -v n="$methods" 'BEGIN {
+	print "class Table {";
+	print "  lookup(k : Int, s : String) : Int { k + s.length() };";
+	print "  row(k : Int) : Table { self };";
+	print "};";
+	print "class Main inherits IO {";
+	print "  main() : Object { out_int((new C0).m0(1)) };";
+	print "};";
+	for ( i = 0; i < n; i++)
+	{
+		if ( i % 10 == 0)
+		{
+			printf "%sclass C%d {\n", i ? "};\n" : "", i / 10;
+		}
+		c = i % 8;
+		printf "  m%d(a : Int) : Int { {\n", i;
+		for ( s = 0; s < 4; s++)
+		{
+			printf "    (new Table).lookup(%d * 4 + %d, \"row\".concat(\"col%d\"));\n", s, c, s;
+			printf "    if %d < %d then (new Table).row(%d).lookup(~%d, \"x\") else %d / 2 fi;\n", c, s, s, c, s;
+			printf "    while not (%d = %d) loop isvoid new Table pool;\n", s, s;
+		}
+		printf "    a + %d;\n  } };\n", i;
+	}
+	print "};";
+}' > "$input" || exit 1
+
+echo "$methods methods, `wc -c < "$input"` bytes"
+for mode in 0 1
+do
+	echo "COOL_PARSE_SHARE=$mode"
+	COOL_PARSE_SHARE=$mode COOL_PARSE_STATS=1 COOLC_TIMES=1 \
+		"$coolc" -o "$output" "$input" 2> "$stats" || exit 1
+	sed 's/^/  /' "$stats"
+done
@@ -0,0 +1,129 @@
+#!/bin/sh
+#
+# Checks that hash-consing in the parser (COOL_PARSE_SHARE) does not
+# change what coolc makes of a program: for every file given, and for a
+# set of inputs written here that repeat the same subtrees in methods
+# and classes with different scopes (the same `new A`, arithmetic,
+# dispatch on a new object and constants, under different attributes,
+# formals, lets and cases, and in classes that inherit different
+# methods), the code must be the same with sharing on and off.
+#
+#   ./share-verify.sh [-c coolc] [file.cl ...]
+#
+# coolc    compiler to run (default ./coolc)
+#
+# A program with errors must fail both ways, and sharing may only drop
+# errors, never add one: an error in a repeated subtree is reported
+# once, at the first occurrence's line (see cool.y).  Each input that
+# fails is named with the start of the diff; the exit status is the
+# number of such inputs (at most 255).
+#
+#   ./share-verify.sh ../../examples/*.cl
+
+coolc=./coolc
+while getopts c: opt
+do
+	case $opt in
+	c) coolc=$OPTARG ;;
+	*) exit 2 ;;
+	esac
+done
+shift `expr $OPTIND - 1`
+
+dir=${TMPDIR:-/tmp}/share-verify.$$
+trap 'rm -rf "$dir"' EXIT INT TERM
+mkdir "$dir" || exit 2
+
+cat > "$dir/scopes.cl" <<'EOF'
+class A {
+  n : Int <- 3;
+  f(k : Int) : Int { n + k };
+  g() : A { new A };
+};
+
+class B inherits A {
+  f(k : Int) : Int { k * 2 };
+};
+
+class C {
+  n : String <- "n";
+  a : A <- new A;
+  m(x : Int) : Int { (new A).f(1 + 2) + x };
+  p(b : B) : Object { { new A; b.f(1 + 2); (new A).g(); } };
+};
+
+class D inherits C {
+  x : Bool <- true;
+  m(y : Int) : Int { let n : A <- new A in n.f(1 + 2) + (1 + 2) * y };
+  q() : Int { case new A of a : A => (new A).f(1 + 2); b : B => 1 + 2; esac };
+};
+
+class E inherits B {
+  r() : Int { if 1 + 2 < 4 then f(1 + 2) else (new A).f(1 + 2) fi };
+  s() : Int { { while isvoid new A loop 1 + 2 pool; ~(1 + 2); } };
+};
+
+class Main inherits IO {
+  main() : Object { {
+    out_int((new D).m(4));
+    out_int((new D).q());
+    out_int((new E).r());
+    out_int((new A).f(1 + 2));
+  } };
+};
+EOF
+
+cat > "$dir/errors.cl" <<'EOF'
+class A {
+  f() : Int { 1 + 2 };
+};
+
+class C {
+  a : Int;
+  m() : Object { { new Missing; 1 + "two"; (new A).g(); } };
+};
+
+class D {
+  b : String;
+  m() : Object { { new Missing; 1 + "two"; (new A).g(); } };
+};
+
+class Main {
+  main() : Object { (new A).f() + (new Missing) };
+};
+EOF
+
+checked=0
+failed=0
+for file in "$dir/scopes.cl" "$dir/errors.cl" "$@"
+do
+	for mode in 0 1
+	do
+		COOL_PARSE_SHARE=$mode "$coolc" -o "$dir/$mode.s" "$file" > "$dir/$mode.err" 2>&1
+		echo "exit $?" > "$dir/$mode.exit"
+	done
+	checked=`expr $checked + 1`
+	if ! cmp -s "$dir/0.exit" "$dir/1.exit"
+	then
+		echo "$file: `cat "$dir/0.exit"` unshared, `cat "$dir/1.exit"` shared"
+		failed=`expr $failed + 1`
+	elif [ "`cat "$dir/0.exit"`" = "exit 0" ]
+	then
+		if ! cmp -s "$dir/0.s" "$dir/1.s"
+		then
+			echo "$file: code differs"
+			diff "$dir/0.s" "$dir/1.s" | head -10
+			failed=`expr $failed + 1`
+		fi
+	elif grep -v -x -F -f "$dir/0.err" "$dir/1.err" > "$dir/extra"
+	then
+		echo "$file: errors only when shared"
+		head -10 "$dir/extra"
+		failed=`expr $failed + 1`
+	fi
+	rm -f "$dir/0.s" "$dir/1.s"
+done
+
+echo "$checked files, $failed differ"
+[ $failed -gt 255 ] && failed=255
+exit $failed